@@ -0,0 +1,387 @@
+#include "blockCompression.h"
+#include "jobSystem.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const char* blockFormatNames[BlockFormatCount] = { "BC1", "BC4", "BC5", "BC7" };
+
+int blockBytes(BlockFormat format) {
+    return format == BlockBC1 || format == BlockBC4 ? 8 : 16;
+}
+
+size_t compressedSize(BlockFormat format, int width, int height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+// 16 texels, 0..255 per channel
+struct Block {
+    float texels[16][4];
+};
+
+// a palette stored channel by channel, padded to a multiple of 4 entries so four
+// entries are compared against a texel at once
+struct Palette {
+    int size;
+    int channels;
+    float values[4][16];
+};
+
+// picks the closest palette entry for every texel, returns the summed squared error
+static float nearestIndices(const Block& block, const Palette& palette, int firstChannel, unsigned char indices[16]) {
+    float total = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float best = 1e30f;
+        for (int group = 0; group < palette.size; group += 4) {
+            f32x4 distance = splat4(0.0f);
+            for (int c = 0; c < palette.channels; ++c) {
+                f32x4 difference = splat4(block.texels[i][firstChannel + c]) - load4(&palette.values[c][group]);
+                distance = distance + difference * difference;
+            }
+            float lanes[4];
+            store4(lanes, distance);
+            for (int lane = 0; lane < 4 && group + lane < palette.size; ++lane) {
+                if (lanes[lane] < best) {
+                    best = lanes[lane];
+                    indices[i] = (unsigned char)(group + lane);
+                }
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+// mean and principal axis of the first channels of the block, by power iteration on the
+// covariance matrix. a flat block gives a zero axis
+static void principalAxis(const Block& block, int channels, float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; ++c) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            mean[c] += block.texels[i][c] / 16.0f;
+        }
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                covariance[a][b] += (block.texels[i][a] - mean[a]) * (block.texels[i][b] - mean[b]);
+            }
+        }
+    }
+
+    float vector[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                next[a] += covariance[a][b] * vector[b];
+            }
+            length += next[a] * next[a];
+        }
+        if (length < 1e-12f) {
+            return;
+        }
+        length = std::sqrt(length);
+        for (int a = 0; a < channels; ++a) {
+            vector[a] = next[a] / length;
+        }
+    }
+    for (int c = 0; c < channels; ++c) {
+        axis[c] = vector[c];
+    }
+}
+
+// end points of the block along its principal axis
+static void axisEndpoints(const Block& block, int channels, float low[4], float high[4]) {
+    float mean[4], axis[4];
+    principalAxis(block, channels, mean, axis);
+
+    float minimum = 0.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            t += (block.texels[i][c] - mean[c]) * axis[c];
+        }
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    for (int c = 0; c < 4; ++c) {
+        low[c] = std::min(std::max(mean[c] + minimum * axis[c], 0.0f), 255.0f);
+        high[c] = std::min(std::max(mean[c] + maximum * axis[c], 0.0f), 255.0f);
+    }
+}
+
+static void writeLittleEndian(unsigned char* out, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// ---- BC1
+
+static unsigned short packRgb565(const float color[4]) {
+    int r = (int)std::lround(color[0] * 31.0f / 255.0f);
+    int g = (int)std::lround(color[1] * 63.0f / 255.0f);
+    int b = (int)std::lround(color[2] * 31.0f / 255.0f);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRgb565(unsigned short packed, float color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (float)((r << 3) | (r >> 2));
+    color[1] = (float)((g << 2) | (g >> 4));
+    color[2] = (float)((b << 3) | (b >> 2));
+}
+
+// palette order of the four colour mode: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+static const float bc1Weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+static float bc1Indices(const Block& block, unsigned short c0, unsigned short c1, unsigned char indices[16]) {
+    float e0[3], e1[3];
+    unpackRgb565(c0, e0);
+    unpackRgb565(c1, e1);
+
+    Palette palette = { 4, 3, {} };
+    for (int k = 0; k < 4; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            palette.values[c][k] = e0[c] * bc1Weights[k] + e1[c] * (1.0f - bc1Weights[k]);
+        }
+    }
+    return nearestIndices(block, palette, 0, indices);
+}
+
+// the end points that fit the chosen indices best in the least squares sense
+static bool bc1Refit(const Block& block, const unsigned char indices[16], float e0[4], float e1[4]) {
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        float a = bc1Weights[indices[i]], b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a * block.texels[i][c];
+            bx[c] += b * block.texels[i][c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+        e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+static float encodeBC1Endpoints(const Block& block, const float e0[4], const float e1[4], unsigned char* out, unsigned char indices[16]) {
+    unsigned short c0 = packRgb565(e0), c1 = packRgb565(e1);
+    // c0 > c1 selects the four colour mode, equal end points need no indices at all
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+    std::fill(indices, indices + 16, 0);
+    float error = 0.0f;
+    if (c0 != c1) {
+        error = bc1Indices(block, c0, c1, indices);
+    } else {
+        float color[3];
+        unpackRgb565(c0, color);
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                error += (block.texels[i][c] - color[c]) * (block.texels[i][c] - color[c]);
+            }
+        }
+    }
+
+    unsigned int bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        bits |= (unsigned int)indices[i] << (2 * i);
+    }
+    writeLittleEndian(out, c0, 2);
+    writeLittleEndian(out + 2, c1, 2);
+    writeLittleEndian(out + 4, bits, 4);
+    return error;
+}
+
+static void encodeBC1(const Block& block, unsigned char* out) {
+    float e0[4], e1[4];
+    axisEndpoints(block, 3, e1, e0);
+    unsigned char indices[16];
+    float error = encodeBC1Endpoints(block, e0, e1, out, indices);
+
+    // one least squares pass over the chosen indices, kept when it lowers the error
+    if (bc1Refit(block, indices, e0, e1)) {
+        unsigned char refined[8];
+        if (encodeBC1Endpoints(block, e0, e1, refined, indices) < error) {
+            std::memcpy(out, refined, 8);
+        }
+    }
+}
+
+// ---- BC4 / BC5
+
+// eight value mode: a0 > a1, palette a0, a1 and six steps in between
+static void encodeBC4(const Block& block, int channel, unsigned char* out) {
+    float minimum = 255.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        minimum = std::min(minimum, block.texels[i][channel]);
+        maximum = std::max(maximum, block.texels[i][channel]);
+    }
+    int a0 = (int)std::lround(maximum), a1 = (int)std::lround(minimum);
+
+    unsigned char indices[16] = {};
+    if (a0 != a1) {
+        Palette palette = { 8, 1, {} };
+        palette.values[0][0] = (float)a0;
+        palette.values[0][1] = (float)a1;
+        for (int k = 2; k < 8; ++k) {
+            palette.values[0][k] = ((8 - k) * a0 + (k - 1) * a1) / 7.0f;
+        }
+        nearestIndices(block, palette, channel, indices);
+    }
+
+    unsigned long long bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        bits |= (unsigned long long)indices[i] << (3 * i);
+    }
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    writeLittleEndian(out + 2, bits, 6);
+}
+
+// ---- BC7
+
+// writes values into the 128 bit block lowest bit first, the order BC7 fields are laid out in
+struct BitWriter {
+    unsigned char* out;
+    int position = 0;
+
+    void write(unsigned int value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            if (value & (1u << i)) {
+                out[position >> 3] |= (unsigned char)(1 << (position & 7));
+            }
+        }
+    }
+};
+
+static const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 7 bit end point plus a p-bit shared by its four channels, whichever p-bit lands closer
+static void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pBit) {
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; ++p) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            candidate[c] = std::min(std::max((int)std::lround((endpoint[c] - p) / 2.0f), 0), 127);
+            float value = (float)((candidate[c] << 1) | p);
+            error += (value - endpoint[c]) * (value - endpoint[c]);
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+// mode 6: RGBA end points of 7 bits plus a p-bit each, one subset and 4 bit indices
+static void encodeBC7(const Block& block, unsigned char* out) {
+    float low[4], high[4];
+    axisEndpoints(block, 4, low, high);
+
+    int q[2][4], p[2];
+    quantizeBC7Endpoint(low, q[0], p[0]);
+    quantizeBC7Endpoint(high, q[1], p[1]);
+
+    Palette palette = { 16, 4, {} };
+    for (int c = 0; c < 4; ++c) {
+        int e0 = (q[0][c] << 1) | p[0];
+        int e1 = (q[1][c] << 1) | p[1];
+        for (int k = 0; k < 16; ++k) {
+            palette.values[c][k] = (float)(((64 - bc7Weights4[k]) * e0 + bc7Weights4[k] * e1 + 32) >> 6);
+        }
+    }
+    unsigned char indices[16];
+    nearestIndices(block, palette, 0, indices);
+
+    // the first index is stored without its top bit, swap the end points if it is set
+    if (indices[0] & 8) {
+        std::swap(q[0], q[1]);
+        std::swap(p[0], p[1]);
+        for (int i = 0; i < 16; ++i) {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer = { out };
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(q[0][c], 7);
+        writer.write(q[1][c], 7);
+    }
+    writer.write(p[0], 1);
+    writer.write(p[1], 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(indices[i], 4);
+    }
+}
+
+// ----
+
+static void fetchBlock(const unsigned char* pixels, int width, int height, int channels, int bx, int by, Block& block) {
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            int sy = std::min(by * 4 + y, height - 1);
+            const unsigned char* texel = pixels + ((size_t)sy * width + sx) * channels;
+            float* out = block.texels[y * 4 + x];
+            for (int c = 0; c < 4; ++c) {
+                if (c < channels) {
+                    out[c] = texel[c];
+                } else if (c < 3 && channels == 1) {
+                    out[c] = texel[0];
+                } else {
+                    out[c] = c == 3 ? 255.0f : 0.0f;
+                }
+            }
+        }
+    }
+}
+
+std::vector<unsigned char> compressImage(const unsigned char* pixels, int width, int height, int channels, BlockFormat format) {
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    int bytes = blockBytes(format);
+    std::vector<unsigned char> compressed(compressedSize(format, width, height));
+
+    parallelFor(blocksY, 1, [&](int begin, int end) {
+        Block block;
+        for (int by = begin; by < end; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                fetchBlock(pixels, width, height, channels, bx, by, block);
+                unsigned char* out = &compressed[((size_t)by * blocksX + bx) * bytes];
+                switch (format) {
+                    case BlockBC1: encodeBC1(block, out); break;
+                    case BlockBC4: encodeBC4(block, 0, out); break;
+                    case BlockBC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+                    case BlockBC7: encodeBC7(block, out); break;
+                    default: break;
+                }
+            }
+        }
+    });
+    return compressed;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// CPU encoders for the GPU block formats. every 4x4 texel block becomes 8 or 16 bytes,
+// blocks are encoded on the worker threads and palette searches use simd.h
+enum BlockFormat {
+    BlockBC1, // RGB, 4 bits per texel
+    BlockBC4, // one channel, 4 bits per texel
+    BlockBC5, // two channels, 8 bits per texel
+    BlockBC7, // RGBA, 8 bits per texel. only mode 6 (one subset, 4 bit indices) is produced
+    BlockFormatCount
+};
+
+extern const char* blockFormatNames[BlockFormatCount];
+
+int blockBytes(BlockFormat format);
+size_t compressedSize(BlockFormat format, int width, int height);
+
+// pixels is width * height texels of channels bytes. BC1 and BC7 replicate a single channel
+// into grey, partial blocks at the right and bottom repeat the edge texels
+std::vector<unsigned char> compressImage(const unsigned char* pixels, int width, int height, int channels, BlockFormat format);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// everything the terrain renderers need to know about the camera for one frame
+struct FrameCamera {
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::mat4 viewProjection;
+    glm::vec3 position;
+    float fieldOfView;  // vertical, in radians
+    int viewportHeight; // in pixels, used to turn world space errors into screen space
+};
@@ -0,0 +1,54 @@
+#include "cameraBuffer.h"
+#include "glState.h"
+#include <cstring>
+#include <iostream>
+
+CameraBuffer createCameraBuffer() {
+    CameraBuffer cameraBuffer;
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    cameraBuffer.alignment = alignment;
+
+    // room for one aligned copy per frame wherever the segment happens to start
+    cameraBuffer.stream = createStreamBuffer(GL_UNIFORM_BUFFER, sizeof(CameraUniforms) + alignment);
+    return cameraBuffer;
+}
+
+void attachCameraBlock(const ShaderProgram& shader) {
+    const ShaderBlock* block = findUniformBlock(shader, "Camera");
+    if (!block) {
+        std::cerr << "Error::Uniform block 'Camera' not found in program " << shader.program << "\n";
+        return;
+    }
+    if (block->dataSize != (GLint)sizeof(CameraUniforms)) {
+        std::cerr << "Error::Uniform block 'Camera' of program " << shader.program << " is " << block->dataSize
+                  << " bytes, CameraUniforms is " << sizeof(CameraUniforms) << "\n";
+    }
+    glUniformBlockBinding(shader.program, block->index, cameraBlockBinding);
+}
+
+void updateCameraBuffer(CameraBuffer& cameraBuffer, const FrameCamera& camera) {
+    CameraUniforms uniforms;
+    uniforms.viewMatrix = camera.viewMatrix;
+    uniforms.projectionMatrix = camera.projectionMatrix;
+    uniforms.viewProjection = camera.viewProjection;
+    uniforms.position = glm::vec4(camera.position, 1.0f);
+
+    StreamBuffer& stream = cameraBuffer.stream;
+    beginStreamFrame(stream);
+
+    GLintptr offset = 0;
+    bindBuffer(GL_UNIFORM_BUFFER, stream.buffer);
+    void* destination = mapStreamRange(stream, sizeof(CameraUniforms), cameraBuffer.alignment, offset);
+    if (!destination) {
+        return;
+    }
+    std::memcpy(destination, &uniforms, sizeof(CameraUniforms));
+    unmapStreamRange(stream);
+
+    bindBufferRange(GL_UNIFORM_BUFFER, cameraBlockBinding, stream.buffer, offset, sizeof(CameraUniforms));
+}
+
+void endCameraFrame(CameraBuffer& cameraBuffer) {
+    endStreamFrame(cameraBuffer.stream);
+}
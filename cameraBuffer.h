@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "shaderProgram.h"
+#include "streamBuffer.h"
+
+// the camera of the frame in one std140 uniform block shared by every program, so it
+// is written once per frame instead of once per program. shaders declare
+//
+//     layout(std140) uniform Camera {
+//         mat4 viewMatrix;
+//         mat4 projectionMatrix;
+//         mat4 viewProjection;
+//         vec4 cameraPosition;
+//     };
+const GLuint cameraBlockBinding = 0;
+
+// same layout as the Camera block, std140 puts every member on a 16 byte boundary
+struct CameraUniforms {
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::mat4 viewProjection;
+    glm::vec4 position; // w unused
+};
+
+struct CameraBuffer {
+    StreamBuffer stream;
+    GLsizeiptr alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+};
+
+CameraBuffer createCameraBuffer();
+// points the program's Camera block at cameraBlockBinding, complains if the layout differs
+void attachCameraBlock(const ShaderProgram& shader);
+// writes this frame's camera and binds it, call before the first draw of the frame
+void updateCameraBuffer(CameraBuffer& cameraBuffer, const FrameCamera& camera);
+// after the frame's last draw, see endStreamFrame
+void endCameraFrame(CameraBuffer& cameraBuffer);
@@ -0,0 +1,203 @@
+#include "cdlodTerrain.h"
+#include "frustum.h"
+#include "glState.h"
+#include "renderStats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static CdlodPatch createPatch(int dimension, GLuint instanceBuffer) {
+    CdlodPatch patch;
+    patch.dimension = dimension;
+
+    std::vector<glm::vec2> vertices;
+    for (int j = 0; j <= dimension; ++j) {
+        for (int i = 0; i <= dimension; ++i) {
+            vertices.push_back(glm::vec2(i / (float)dimension, j / (float)dimension));
+        }
+    }
+
+    std::vector<unsigned short> indices;
+    for (int j = 0; j < dimension; ++j) {
+        for (int i = 0; i < dimension; ++i) {
+            unsigned short a = j * (dimension + 1) + i;
+            unsigned short b = a + 1;
+            unsigned short c = a + dimension + 1;
+            unsigned short d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    patch.indexCount = static_cast<int>(indices.size());
+
+    glGenVertexArrays(1, &patch.vao);
+    bindVertexArray(patch.vao);
+
+    glGenBuffers(1, &patch.vbo);
+    bindBuffer(GL_ARRAY_BUFFER, patch.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &patch.ibo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, patch.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    // one vec4 per node, advanced once per instance. the offset is set again at every
+    // draw to wherever this frame's instances landed in the stream buffer
+    bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+
+    bindVertexArray(0);
+    return patch;
+}
+
+CdlodTerrain createCdlodTerrain(const ShaderProgram& shader, GLuint heightTexture) {
+    CdlodTerrain terrain;
+    terrain.shaderProgram = shader.program;
+    terrain.heightTexture = heightTexture;
+    terrain.pyramid = buildHeightPyramid();
+
+    // root node covers the whole pyramid
+    terrain.levels = 1;
+    while ((cdlodLeafQuads << (terrain.levels - 1)) < terrain.pyramid.size) {
+        terrain.levels++;
+    }
+    if (terrain.levels > cdlodMaxLevels) {
+        std::cerr << "Error::CDLOD needs " << terrain.levels << " levels, only " << cdlodMaxLevels << " supported\n";
+        terrain.levels = cdlodMaxLevels;
+    }
+
+    // every level reaches twice as far as the one below, morphing over the last third
+    float previous = 0.0f;
+    for (int lod = 0; lod < terrain.levels; ++lod) {
+        terrain.ranges[lod] = cdlodLeafQuads * 1.5f * (1 << lod);
+        float morphStart = previous + (terrain.ranges[lod] - previous) * 0.66f;
+        terrain.morphRanges[lod] = glm::vec2(morphStart, terrain.ranges[lod]);
+        previous = terrain.ranges[lod];
+    }
+
+    terrain.instanceStream = createStreamBuffer(GL_ARRAY_BUFFER, 2 * cdlodMaxInstances * sizeof(glm::vec4));
+    terrain.fullPatch = createPatch(cdlodPatchSize, terrain.instanceStream.buffer);
+    terrain.quarterPatch = createPatch(cdlodPatchSize / 2, terrain.instanceStream.buffer);
+
+    useProgram(shader.program);
+    terrain.gridDimension = findUniform<float>(shader, "gridDimension");
+    setUniform(findUniform<int>(shader, "textureSampler"), 0);
+    setUniform(findUniform<int>(shader, "heightSampler"), 1);
+    setUniform(findUniform<float>(shader, "mapSize"), (float)fineSize);
+    setUniform(findUniform<glm::vec2>(shader, "morphRange"), terrain.morphRanges, terrain.levels);
+
+    return terrain;
+}
+
+static bool sphereIntersectsBox(glm::vec3 center, float radius, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    glm::vec3 closest = glm::clamp(center, boundsMin, boundsMax);
+    glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+// returns false when the node is out of its lod range, so the parent has to cover
+// its area. nodes outside the frustum or the map count as handled
+static bool selectNode(CdlodTerrain& terrain, const Frustum& frustum, const FrameCamera& camera, int lod, int x, int z) {
+    if (x >= fineSize - 1 || z >= fineSize - 1) {
+        return true;
+    }
+
+    int size = cdlodLeafQuads << lod;
+    int pyramidLevel = 0;
+    while ((1 << pyramidLevel) < size) {
+        pyramidLevel++;
+    }
+    glm::vec2 minMax = terrain.pyramid.at(pyramidLevel, x / size, z / size);
+
+    float offset = fineSize / 2.0f;
+    float x1 = std::min(x + size, fineSize - 1);
+    float z1 = std::min(z + size, fineSize - 1);
+    glm::vec3 boundsMin(x - offset, minMax.x, -(z1 - offset));
+    glm::vec3 boundsMax(x1 - offset, minMax.y, -(z - offset));
+
+    if (!sphereIntersectsBox(camera.position, terrain.ranges[lod], boundsMin, boundsMax)) {
+        return false;
+    }
+    if (!boxInFrustum(frustum, boundsMin, boundsMax)) {
+        return true;
+    }
+
+    glm::vec4 node(x, z, size, lod);
+    if (lod == 0 || !sphereIntersectsBox(camera.position, terrain.ranges[lod - 1], boundsMin, boundsMax)) {
+        terrain.fullPatch.instances.push_back(node);
+        return true;
+    }
+
+    int half = size / 2;
+    for (int child = 0; child < 4; ++child) {
+        int childX = x + (child & 1) * half;
+        int childZ = z + (child >> 1) * half;
+        if (!selectNode(terrain, frustum, camera, lod - 1, childX, childZ)) {
+            terrain.quarterPatch.instances.push_back(glm::vec4(childX, childZ, half, lod));
+        }
+    }
+    return true;
+}
+
+void selectCdlodNodes(CdlodTerrain& terrain, const FrameCamera& camera) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    terrain.fullPatch.instances.clear();
+    terrain.quarterPatch.instances.clear();
+
+    Frustum frustum = extractFrustumPlanes(camera.viewProjection);
+    int rootLod = terrain.levels - 1;
+    if (!selectNode(terrain, frustum, camera, rootLod, 0, 0)) {
+        // the root is always drawn, whatever the distance
+        terrain.fullPatch.instances.push_back(glm::vec4(0.0f, 0.0f, cdlodLeafQuads << rootLod, rootLod));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    renderStats.selectionMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+static void drawPatch(CdlodTerrain& terrain, CdlodPatch& patch) {
+    if (patch.instances.empty()) {
+        return;
+    }
+
+    GLsizeiptr size = patch.instances.size() * sizeof(glm::vec4);
+    GLintptr offset = 0;
+    bindBuffer(GL_ARRAY_BUFFER, terrain.instanceStream.buffer);
+    void* destination = mapStreamRange(terrain.instanceStream, size, sizeof(glm::vec4), offset);
+    if (!destination) {
+        return;
+    }
+    std::memcpy(destination, patch.instances.data(), size);
+    unmapStreamRange(terrain.instanceStream);
+
+    bindVertexArray(patch.vao);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)offset);
+
+    setUniform(terrain.gridDimension, (float)patch.dimension);
+    glDrawElementsInstanced(GL_TRIANGLES, patch.indexCount, GL_UNSIGNED_SHORT, (void*)0, (GLsizei)patch.instances.size());
+    renderStats.drawCalls++;
+
+    renderStats.chunksSubmitted += static_cast<int>(patch.instances.size());
+    renderStats.trianglesDrawn += (long long)patch.instances.size() * patch.indexCount / 3;
+}
+
+void drawCdlodTerrain(CdlodTerrain& terrain, GLuint texture, const FrameCamera& camera) {
+    selectCdlodNodes(terrain, camera);
+
+    useProgram(terrain.shaderProgram); // camera matrices come from the shared Camera block
+
+    activeTexture(1);
+    bindTexture(GL_TEXTURE_2D, terrain.heightTexture);
+    activeTexture(0);
+    bindTexture(GL_TEXTURE_2D, texture);
+
+    beginStreamFrame(terrain.instanceStream);
+    drawPatch(terrain, terrain.fullPatch);
+    drawPatch(terrain, terrain.quarterPatch);
+    endStreamFrame(terrain.instanceStream);
+}
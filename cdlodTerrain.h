@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "heightPyramid.h"
+#include "shaderProgram.h"
+#include "streamBuffer.h"
+
+// Continuous Distance-Dependent LOD (Strugar): a quadtree over the height map where
+// every selected node draws the same grid patch, and vertices morph towards the
+// next coarser level before a node hands over to its parent
+const int cdlodLeafQuads = 16;  // smallest node, in height map quads
+const int cdlodPatchSize = 16;  // quads per side of the instanced patch
+const int cdlodMaxLevels = 8;   // size of the morphRange uniform array
+const int cdlodMaxInstances = 2048; // per patch and frame, sizes the instance stream
+
+// a grid mesh in [0, 1]^2 plus the nodes drawn with it, streamed as instance data
+struct CdlodPatch {
+    GLuint vao, vbo, ibo;
+    int dimension;
+    int indexCount;
+    std::vector<glm::vec4> instances; // x, z corner in height map units, size, lod
+};
+
+struct CdlodTerrain {
+    GLuint shaderProgram;
+    GLuint heightTexture;
+    HeightPyramid pyramid;
+    int levels;
+    float ranges[cdlodMaxLevels];
+    glm::vec2 morphRanges[cdlodMaxLevels];
+    CdlodPatch fullPatch;    // whole node at its own lod
+    CdlodPatch quarterPatch; // one child of a node at the parent's lod, half the vertices
+    StreamBuffer instanceStream;
+
+    Uniform<float> gridDimension;
+};
+
+CdlodTerrain createCdlodTerrain(const ShaderProgram& shader, GLuint heightTexture);
+void selectCdlodNodes(CdlodTerrain& terrain, const FrameCamera& camera);
+void drawCdlodTerrain(CdlodTerrain& terrain, GLuint texture, const FrameCamera& camera);
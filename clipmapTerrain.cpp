@@ -0,0 +1,203 @@
+#include "clipmapTerrain.h"
+#include "glState.h"
+#include "renderStats.h"
+#include "terrain.h"
+#include <algorithm>
+#include <cmath>
+
+static int wrap(int value, int size) {
+    int result = value % size;
+    return result < 0 ? result + size : result;
+}
+
+// triangles of every cell outside [holeX, holeX + grid/2) x [holeZ, holeZ + grid/2),
+// a negative hole gives the full grid
+static void buildLevelIndices(int holeX, int holeZ, std::vector<unsigned short>& indices) {
+    const int holeSize = clipmapGrid / 2;
+    for (int j = 0; j < clipmapGrid; ++j) {
+        for (int i = 0; i < clipmapGrid; ++i) {
+            if (holeX >= 0 && i >= holeX && i < holeX + holeSize && j >= holeZ && j < holeZ + holeSize) {
+                continue;
+            }
+            unsigned short a = j * (clipmapGrid + 1) + i;
+            unsigned short b = a + 1;
+            unsigned short c = a + clipmapGrid + 1;
+            unsigned short d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+}
+
+ClipmapTerrain createClipmapTerrain(const ShaderProgram& shader, HeightSource heightSource) {
+    ClipmapTerrain terrain;
+    terrain.shaderProgram = shader.program;
+    terrain.heightSource = heightSource;
+
+    std::vector<glm::vec2> vertices;
+    for (int j = 0; j <= clipmapGrid; ++j) {
+        for (int i = 0; i <= clipmapGrid; ++i) {
+            vertices.push_back(glm::vec2(i, j));
+        }
+    }
+
+    std::vector<unsigned short> indices;
+    terrain.fullOffset = 0;
+    buildLevelIndices(-1, -1, indices);
+    terrain.fullCount = static_cast<int>(indices.size());
+    for (int dz = 0; dz < 2; ++dz) {
+        for (int dx = 0; dx < 2; ++dx) {
+            terrain.ringOffset[dz][dx] = static_cast<int>(indices.size());
+            buildLevelIndices(clipmapGrid / 4 + dx, clipmapGrid / 4 + dz, indices);
+            terrain.ringCount[dz][dx] = static_cast<int>(indices.size()) - terrain.ringOffset[dz][dx];
+        }
+    }
+
+    glGenVertexArrays(1, &terrain.vao);
+    bindVertexArray(terrain.vao);
+
+    glGenBuffers(1, &terrain.vbo);
+    bindBuffer(GL_ARRAY_BUFFER, terrain.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &terrain.ibo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    bindVertexArray(0);
+
+    glGenTextures(1, &terrain.heightTexture);
+    bindTexture(GL_TEXTURE_2D_ARRAY, terrain.heightTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, clipmapTextureSize, clipmapTextureSize, clipmapLevels, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    for (int level = 0; level < clipmapLevels; ++level) {
+        terrain.resident[level] = false;
+    }
+
+    useProgram(shader.program);
+    terrain.level = findUniform<int>(shader, "level");
+    terrain.levelOrigin = findUniform<glm::ivec2>(shader, "levelOrigin");
+    terrain.cameraGridPos = findUniform<glm::vec2>(shader, "cameraGridPos");
+    terrain.spacing = findUniform<float>(shader, "spacing");
+    setUniform(findUniform<int>(shader, "textureSampler"), 0);
+    setUniform(findUniform<int>(shader, "heightSampler"), 1);
+    setUniform(findUniform<int>(shader, "levelCount"), clipmapLevels);
+    setUniform(findUniform<int>(shader, "textureSize"), clipmapTextureSize);
+    setUniform(findUniform<float>(shader, "mapSize"), (float)fineSize);
+
+    // the blend must be complete before the outermost vertex, which can sit
+    // as close as grid / 2 - 2 vertices to the camera because of the snapping
+    const float transitionWidth = clipmapGrid / 8.0f;
+    setUniform(findUniform<float>(shader, "transitionWidth"), transitionWidth);
+    setUniform(findUniform<float>(shader, "transitionStart"), clipmapGrid / 2.0f - 2.0f - transitionWidth);
+
+    return terrain;
+}
+
+// samples the height source over a block of level vertices and writes it into the
+// level's layer, split wherever the block wraps around the edge of the texture
+static void uploadRegion(ClipmapTerrain& terrain, int level, int x0, int z0, int width, int depth) {
+    if (width <= 0 || depth <= 0) {
+        return;
+    }
+
+    float spacing = static_cast<float>(1 << level);
+    for (int z = z0; z < z0 + depth;) {
+        int texelZ = wrap(z, clipmapTextureSize);
+        int rows = std::min(z0 + depth - z, clipmapTextureSize - texelZ);
+
+        for (int x = x0; x < x0 + width;) {
+            int texelX = wrap(x, clipmapTextureSize);
+            int columns = std::min(x0 + width - x, clipmapTextureSize - texelX);
+
+            terrain.staging.resize(columns * rows);
+            for (int j = 0; j < rows; ++j) {
+                for (int i = 0; i < columns; ++i) {
+                    terrain.staging[j * columns + i] = terrain.heightSource((x + i) * spacing, (z + j) * spacing);
+                }
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, texelX, texelZ, level, columns, rows, 1,
+                            GL_RED, GL_FLOAT, terrain.staging.data());
+            renderStats.texelsUploaded += columns * rows;
+
+            x += columns;
+        }
+        z += rows;
+    }
+}
+
+// recentres every level on the camera. origins stay even so each level's
+// vertices land on vertices of the next coarser one
+void updateClipmapTerrain(ClipmapTerrain& terrain, glm::vec3 cameraPosition) {
+    const int vertices = clipmapGrid + 1;
+
+    bindTexture(GL_TEXTURE_2D_ARRAY, terrain.heightTexture);
+    for (int level = 0; level < clipmapLevels; ++level) {
+        float spacing = static_cast<float>(1 << level);
+        glm::ivec2 next(2 * (int)std::floor(cameraPosition.x / spacing / 2.0f) - clipmapGrid / 2,
+                        2 * (int)std::floor(cameraPosition.z / spacing / 2.0f) - clipmapGrid / 2);
+        glm::ivec2 previous = terrain.origin[level];
+
+        if (!terrain.resident[level] || std::abs(next.x - previous.x) >= vertices || std::abs(next.y - previous.y) >= vertices) {
+            uploadRegion(terrain, level, next.x, next.y, vertices, vertices);
+            terrain.resident[level] = true;
+        } else if (next != previous) {
+            // columns that scrolled in, over the full new depth
+            if (next.x > previous.x) {
+                uploadRegion(terrain, level, previous.x + vertices, next.y, next.x - previous.x, vertices);
+            } else if (next.x < previous.x) {
+                uploadRegion(terrain, level, next.x, next.y, previous.x - next.x, vertices);
+            }
+
+            // rows that scrolled in, only over the columns that were already there
+            int keptX0 = std::max(next.x, previous.x);
+            int keptX1 = std::min(next.x, previous.x) + vertices;
+            if (next.y > previous.y) {
+                uploadRegion(terrain, level, keptX0, previous.y + vertices, keptX1 - keptX0, next.y - previous.y);
+            } else if (next.y < previous.y) {
+                uploadRegion(terrain, level, keptX0, next.y, keptX1 - keptX0, previous.y - next.y);
+            }
+        }
+        terrain.origin[level] = next;
+    }
+}
+
+void drawClipmapTerrain(ClipmapTerrain& terrain, GLuint texture, const FrameCamera& camera) {
+    updateClipmapTerrain(terrain, camera.position);
+
+    useProgram(terrain.shaderProgram); // camera matrices come from the shared Camera block
+
+    activeTexture(1);
+    bindTexture(GL_TEXTURE_2D_ARRAY, terrain.heightTexture);
+    activeTexture(0);
+    bindTexture(GL_TEXTURE_2D, texture);
+    bindVertexArray(terrain.vao);
+
+    for (int level = 0; level < clipmapLevels; ++level) {
+        float spacing = static_cast<float>(1 << level);
+        setUniform(terrain.level, level);
+        setUniform(terrain.levelOrigin, terrain.origin[level]);
+        setUniform(terrain.cameraGridPos, glm::vec2(camera.position.x, camera.position.z) / spacing);
+        setUniform(terrain.spacing, spacing);
+
+        int offset = terrain.fullOffset;
+        int count = terrain.fullCount;
+        if (level > 0) {
+            // where the finer level starts, in this level's cells
+            int holeX = terrain.origin[level - 1].x / 2 - terrain.origin[level].x - clipmapGrid / 4;
+            int holeZ = terrain.origin[level - 1].y / 2 - terrain.origin[level].y - clipmapGrid / 4;
+            holeX = std::clamp(holeX, 0, 1);
+            holeZ = std::clamp(holeZ, 0, 1);
+            offset = terrain.ringOffset[holeZ][holeX];
+            count = terrain.ringCount[holeZ][holeX];
+        }
+
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, (void*)(offset * sizeof(unsigned short)));
+        renderStats.drawCalls++;
+        renderStats.trianglesDrawn += count / 3;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "shaderProgram.h"
+
+// geometry clipmap (Losasso/Hoppe): nested square rings of clipmapGrid x clipmapGrid
+// cells centred on the camera, level l with a vertex every 2^l world units.
+// heights live in one texture layer per level, addressed toroidally, so when the
+// camera moves only the rows/columns that scrolled into a level get uploaded
+const int clipmapLevels = 6;
+const int clipmapGrid = 64;                   // cells per side, multiple of 4
+const int clipmapTextureSize = clipmapGrid + 1; // one texel per vertex
+
+// any function answering heights in world space, e.g. getHeightAt
+typedef float (*HeightSource)(float worldX, float worldZ);
+
+struct ClipmapTerrain {
+    GLuint shaderProgram;
+    GLuint heightTexture; // GL_TEXTURE_2D_ARRAY, one layer per level
+    GLuint vao, vbo, ibo;
+    HeightSource heightSource;
+
+    // level 0 draws the full grid, every other level a ring around the level inside it.
+    // the hole starts either clipmapGrid / 4 or one cell later on each axis
+    int fullOffset, fullCount;
+    int ringOffset[2][2], ringCount[2][2];
+
+    glm::ivec2 origin[clipmapLevels]; // first vertex of each level, in that level's vertex units
+    bool resident[clipmapLevels];
+    std::vector<float> staging;
+
+    Uniform<int> level;
+    Uniform<glm::ivec2> levelOrigin;
+    Uniform<glm::vec2> cameraGridPos;
+    Uniform<float> spacing;
+};
+
+ClipmapTerrain createClipmapTerrain(const ShaderProgram& shader, HeightSource heightSource);
+void updateClipmapTerrain(ClipmapTerrain& terrain, glm::vec3 cameraPosition);
+void drawClipmapTerrain(ClipmapTerrain& terrain, GLuint texture, const FrameCamera& camera);
@@ -0,0 +1,92 @@
+#include "compressedTexture.h"
+#include "ddsFile.h"
+#include "mipChain.h"
+#include "stb_image.h"
+#include "textureCache.h"
+#include <chrono>
+#include <iostream>
+
+// color is RGB, the preview has alpha, the PBR maps are single channel data
+const TextureBake textureBakes[] = {
+    { "sand/Ground080_1K-PNG_Color.png", BlockBC1, true },
+    { "sand/Ground080_1K-PNG_AmbientOcclusion.png", BlockBC4, false },
+    { "sand/Ground080_1K-PNG_Roughness.png", BlockBC4, false },
+    { "sand/Ground080_1K-PNG_Displacement.png", BlockBC4, false },
+    { "sand/Ground080.png", BlockBC7, true },
+};
+const int textureBakeCount = sizeof(textureBakes) / sizeof(textureBakes[0]);
+
+std::string bakedTexturePath(const char* path) {
+    std::string baked = path;
+    size_t dot = baked.find_last_of('.');
+    if (dot != std::string::npos && baked.find('/', dot) == std::string::npos) {
+        baked.erase(dot);
+    }
+    return baked + ".dds";
+}
+
+bool bakeTexture(const TextureBake& bake) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<unsigned char> source;
+    int width, height, channels;
+    unsigned char* data = nullptr;
+    if (readSourceFile(bake.path, source) && !source.empty()) {
+        data = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 0);
+    }
+    if (!data) {
+        std::cerr << "Error::Texture could not load texture file: " << bake.path << std::endl;
+        return false;
+    }
+
+    MipSettings settings;
+    settings.srgb = bake.srgb;
+    std::vector<MipLevel> levels = buildMipChain(data, width, height, channels, settings);
+    stbi_image_free(data);
+
+    // the loader compares this with the PNG on disk and ignores the bake once they differ
+    DdsImage image = { bake.format, width, height, {}, textureSourceHash(source) };
+    size_t uncompressed = 0, compressed = 0;
+    for (const MipLevel& level : levels) {
+        image.levels.push_back(compressImage(level.pixels.data(), level.width, level.height, channels, bake.format));
+        uncompressed += level.pixels.size();
+        compressed += image.levels.back().size();
+    }
+
+    std::string path = bakedTexturePath(bake.path);
+    if (!writeDdsFile(path, image)) {
+        return false;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "baked " << path << ": " << blockFormatNames[bake.format] << ", " << levels.size() << " levels, "
+              << compressed << " bytes vs " << uncompressed << " uncompressed (" << (double)uncompressed / compressed
+              << "x smaller) in " << std::chrono::duration<float, std::milli>(end - start).count() << " ms" << std::endl;
+    return true;
+}
+
+void bakeTextures() {
+    for (int i = 0; i < textureBakeCount; ++i) {
+        bakeTexture(textureBakes[i]);
+    }
+}
+
+GLenum blockInternalFormat(BlockFormat format) {
+    switch (format) {
+        case BlockBC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockBC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockBC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockBC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: return GL_NONE;
+    }
+}
+
+// RGTC is core since 3.0, S3TC is an extension everywhere and BPTC needs 4.2
+bool blockFormatSupported(BlockFormat format) {
+    switch (format) {
+        case BlockBC1: return GLEW_EXT_texture_compression_s3tc;
+        case BlockBC4:
+        case BlockBC5: return true;
+        case BlockBC7: return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+        default: return false;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include "blockCompression.h"
+
+// offline baking of the PNG textures into block compressed .dds files beside them, which
+// textureLoader picks up instead of the PNG when the context supports the format
+struct TextureBake {
+    const char* path; // source PNG, the .dds goes next to it
+    BlockFormat format;
+    bool srgb;        // colour data, mips are filtered in linear light
+};
+
+extern const TextureBake textureBakes[];
+extern const int textureBakeCount;
+
+// same path with the extension swapped for .dds
+std::string bakedTexturePath(const char* path);
+bool bakeTexture(const TextureBake& bake);
+// bakes every entry of textureBakes, --bake-textures runs this and exits
+void bakeTextures();
+
+// whether the context can sample the format, textures fall back to their PNG otherwise
+bool blockFormatSupported(BlockFormat format);
+GLenum blockInternalFormat(BlockFormat format);
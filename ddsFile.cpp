@@ -0,0 +1,160 @@
+#include "ddsFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// layout of DDS_HEADER, DDS_PIXELFORMAT and DDS_HEADER_DXT10 from the DirectX docs
+struct DdsPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t masks[4];
+};
+
+struct DdsHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps[4];
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 124, "DDS_HEADER is 124 bytes");
+static_assert(sizeof(DdsHeaderDx10) == 20, "DDS_HEADER_DXT10 is 20 bytes");
+
+const uint32_t ddsMagic = 0x20534444; // "DDS "
+const uint32_t ddsFlagsTexture = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, height, width, pixel format, mip count, linear size
+const uint32_t ddsPixelFormatFourCC = 0x4;
+const uint32_t ddsCapsTexture = 0x1000, ddsCapsMipmap = 0x400000, ddsCapsComplex = 0x8;
+const uint32_t dxgiResourceTexture2D = 3;
+// reserved1[0] tags a source hash in reserved1[1] (low half) and reserved1[2] (high half)
+const uint32_t ddsSourceHashTag = 0x48435253; // "SRCH"
+
+static constexpr uint32_t fourCC(const char code[5]) {
+    return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+// FourCC codes of the legacy header and DXGI formats of the DX10 one, per BlockFormat
+static const uint32_t formatFourCC[BlockFormatCount] = { fourCC("DXT1"), fourCC("ATI1"), fourCC("ATI2"), fourCC("DX10") };
+static const uint32_t formatDxgi[BlockFormatCount] = { 71, 80, 83, 98 }; // BC1, BC4, BC5, BC7 _UNORM
+
+bool writeDdsFile(const std::string& path, const DdsImage& image) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error::Could not write " << path << std::endl;
+        return false;
+    }
+
+    DdsHeader header = {};
+    header.size = sizeof(DdsHeader);
+    header.flags = ddsFlagsTexture;
+    header.height = image.height;
+    header.width = image.width;
+    header.pitchOrLinearSize = (uint32_t)image.levels[0].size();
+    header.mipMapCount = (uint32_t)image.levels.size();
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = ddsPixelFormatFourCC;
+    header.pixelFormat.fourCC = formatFourCC[image.format];
+    header.caps[0] = ddsCapsTexture | ddsCapsMipmap | ddsCapsComplex;
+    if (image.sourceHash) {
+        header.reserved1[0] = ddsSourceHashTag;
+        header.reserved1[1] = (uint32_t)image.sourceHash;
+        header.reserved1[2] = (uint32_t)(image.sourceHash >> 32);
+    }
+
+    file.write(reinterpret_cast<const char*>(&ddsMagic), sizeof(ddsMagic));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (image.format == BlockBC7) {
+        DdsHeaderDx10 dx10 = { formatDxgi[BlockBC7], dxgiResourceTexture2D, 0, 1, 0 };
+        file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    }
+    for (const std::vector<unsigned char>& level : image.levels) {
+        file.write(reinterpret_cast<const char*>(level.data()), level.size());
+    }
+    return file.good();
+}
+
+bool readDdsFile(const std::string& path, DdsImage& image) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint32_t magic = 0;
+    DdsHeader header;
+    if (data.size() < sizeof(magic) + sizeof(header)) {
+        std::cerr << "Error::" << path << " is too short for a DDS file\n";
+        return false;
+    }
+    std::memcpy(&magic, data.data(), sizeof(magic));
+    std::memcpy(&header, data.data() + sizeof(magic), sizeof(header));
+    size_t offset = sizeof(magic) + sizeof(header);
+    if (magic != ddsMagic || header.size != sizeof(DdsHeader) || !(header.pixelFormat.flags & ddsPixelFormatFourCC)) {
+        std::cerr << "Error::" << path << " is not a block compressed DDS file\n";
+        return false;
+    }
+
+    int format = BlockFormatCount;
+    if (header.pixelFormat.fourCC == fourCC("DX10")) {
+        DdsHeaderDx10 dx10;
+        if (data.size() < offset + sizeof(dx10)) {
+            std::cerr << "Error::" << path << " is missing its DX10 header\n";
+            return false;
+        }
+        std::memcpy(&dx10, data.data() + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+        if (dx10.resourceDimension != dxgiResourceTexture2D || dx10.arraySize > 1) {
+            std::cerr << "Error::" << path << " is not a single 2D texture\n";
+            return false;
+        }
+        for (format = 0; format < BlockFormatCount && formatDxgi[format] != dx10.dxgiFormat; ++format) {
+        }
+    } else {
+        for (format = 0; format < BlockFormatCount && formatFourCC[format] != header.pixelFormat.fourCC; ++format) {
+        }
+    }
+    if (format == BlockFormatCount) {
+        std::cerr << "Error::" << path << " uses a block format this loader doesn't know\n";
+        return false;
+    }
+
+    image.format = static_cast<BlockFormat>(format);
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.sourceHash = header.reserved1[0] == ddsSourceHashTag
+        ? ((uint64_t)header.reserved1[2] << 32) | header.reserved1[1] : 0;
+    image.levels.clear();
+    int levelCount = (header.flags & 0x20000) && header.mipMapCount > 0 ? (int)header.mipMapCount : 1;
+    int width = image.width, height = image.height;
+    for (int level = 0; level < levelCount; ++level) {
+        size_t size = compressedSize(image.format, width, height);
+        if (data.size() < offset + size) {
+            std::cerr << "Error::" << path << " is truncated at mip level " << level << "\n";
+            return false;
+        }
+        image.levels.emplace_back(data.begin() + offset, data.begin() + offset + size);
+        offset += size;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return true;
+}
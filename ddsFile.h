@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "blockCompression.h"
+
+// a block compressed 2D texture with its mip chain, as stored in a .dds file.
+// BC1, BC4 and BC5 use the legacy FourCC header, BC7 needs the DX10 extension
+struct DdsImage {
+    BlockFormat format;
+    int width, height;
+    std::vector<std::vector<unsigned char>> levels; // level 0 first
+    uint64_t sourceHash = 0; // textureSourceHash of the PNG it was baked from, 0 when unknown
+};
+
+bool writeDdsFile(const std::string& path, const DdsImage& image);
+// false when the file is missing, not a 2D texture or in a format without an encoder here
+bool readDdsFile(const std::string& path, DdsImage& image);
@@ -0,0 +1,79 @@
+#include "debugLines.h"
+#include "glState.h"
+#include "renderStats.h"
+#include <cstddef>
+#include <cstring>
+
+DebugLines createDebugLines(const ShaderProgram& shader) {
+    DebugLines lines;
+    lines.shaderProgram = shader.program;
+    lines.stream = createStreamBuffer(GL_ARRAY_BUFFER, maxDebugLineVertices * sizeof(DebugLineVertex));
+    lines.vertices.reserve(maxDebugLineVertices);
+
+    // attributes start at the beginning of the buffer, each frame's lines are picked
+    // with the first vertex of the draw
+    glGenVertexArrays(1, &lines.vao);
+    bindVertexArray(lines.vao);
+    bindBuffer(GL_ARRAY_BUFFER, lines.stream.buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugLineVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(DebugLineVertex), (void*)offsetof(DebugLineVertex, color));
+    glEnableVertexAttribArray(1);
+    bindVertexArray(0);
+    bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    lines.worldViewProjection = findUniform<glm::mat4>(shader, "worldViewProjection");
+    return lines;
+}
+
+void addDebugLine(DebugLines& lines, glm::vec3 a, glm::vec3 b, glm::vec3 color) {
+    if ((int)lines.vertices.size() + 2 > maxDebugLineVertices) {
+        return;
+    }
+    lines.vertices.push_back({ a, color });
+    lines.vertices.push_back({ b, color });
+}
+
+void addDebugBox(DebugLines& lines, glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3 color) {
+    auto corner = [&](int i) {
+        return glm::vec3((i & 1) ? boundsMax.x : boundsMin.x,
+                         (i & 2) ? boundsMax.y : boundsMin.y,
+                         (i & 4) ? boundsMax.z : boundsMin.z);
+    };
+    // corners differing in exactly one bit share an edge
+    for (int i = 0; i < 8; ++i) {
+        for (int bit = 1; bit < 8; bit <<= 1) {
+            if (!(i & bit)) {
+                addDebugLine(lines, corner(i), corner(i | bit), color);
+            }
+        }
+    }
+}
+
+void drawDebugLines(DebugLines& lines, const FrameCamera& camera) {
+    if (lines.vertices.empty()) {
+        return;
+    }
+
+    beginStreamFrame(lines.stream);
+
+    GLsizeiptr size = lines.vertices.size() * sizeof(DebugLineVertex);
+    GLintptr offset = 0;
+    bindBuffer(GL_ARRAY_BUFFER, lines.stream.buffer);
+    void* destination = mapStreamRange(lines.stream, size, sizeof(DebugLineVertex), offset);
+    if (destination) {
+        std::memcpy(destination, lines.vertices.data(), size);
+        unmapStreamRange(lines.stream);
+
+        useProgram(lines.shaderProgram);
+        // lines are in world space already
+        setUniform(lines.worldViewProjection, camera.viewProjection);
+
+        bindVertexArray(lines.vao);
+        glDrawArrays(GL_LINES, (GLint)(offset / sizeof(DebugLineVertex)), (GLsizei)lines.vertices.size());
+        renderStats.drawCalls++;
+    }
+
+    endStreamFrame(lines.stream);
+    lines.vertices.clear();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "shaderProgram.h"
+#include "streamBuffer.h"
+
+// coloured line segments collected during the frame and streamed to the GPU in one go,
+// drawn with the plain colour shader (position at location 0, colour at location 1)
+struct DebugLineVertex {
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+const int maxDebugLineVertices = 16384; // per frame
+
+struct DebugLines {
+    GLuint shaderProgram;
+    GLuint vao;
+    StreamBuffer stream;
+    std::vector<DebugLineVertex> vertices;
+
+    Uniform<glm::mat4> worldViewProjection;
+};
+
+DebugLines createDebugLines(const ShaderProgram& shader);
+void addDebugLine(DebugLines& lines, glm::vec3 a, glm::vec3 b, glm::vec3 color);
+void addDebugBox(DebugLines& lines, glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3 color);
+// draws and clears everything added since the last call
+void drawDebugLines(DebugLines& lines, const FrameCamera& camera);
@@ -0,0 +1,333 @@
+#include "depthOcclusion.h"
+#include "simd.h"
+#include "terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+// vertices closer than this in clip space w are not projected
+const float depthNearW = 0.05f;
+
+DepthOcclusion createDepthOcclusion() {
+    DepthOcclusion occlusion;
+    occlusion.job = std::make_unique<Job>();
+
+    // grid lines every depthOccluderStep quads plus the map edge
+    std::vector<int> lines;
+    for (int i = 0; i < fineSize - 1; i += depthOccluderStep) {
+        lines.push_back(i);
+    }
+    lines.push_back(fineSize - 1);
+    int count = static_cast<int>(lines.size());
+
+    // lowest sample of every block between grid lines
+    std::vector<float> blockMin((count - 1) * (count - 1));
+    for (int bz = 0; bz < count - 1; ++bz) {
+        for (int bx = 0; bx < count - 1; ++bx) {
+            float lowest = heightMap[lines[bz]][lines[bx]];
+            for (int z = lines[bz]; z <= lines[bz + 1]; ++z) {
+                for (int x = lines[bx]; x <= lines[bx + 1]; ++x) {
+                    lowest = std::min(lowest, heightMap[z][x]);
+                }
+            }
+            blockMin[bz * (count - 1) + bx] = lowest;
+        }
+    }
+
+    // every block is solid up to its lowest sample, so a box from the lowest point of
+    // the map up to that height lies inside the dunes. its top and sides are the occluders
+    float floor = *std::min_element(blockMin.begin(), blockMin.end());
+    float offset = fineSize / 2.0f;
+    for (int bz = 0; bz < count - 1; ++bz) {
+        for (int bx = 0; bx < count - 1; ++bx) {
+            float top = blockMin[bz * (count - 1) + bx];
+            if (top <= floor) {
+                continue;
+            }
+            int first = static_cast<int>(occlusion.occluderVertices.size());
+            for (int i = 0; i < 8; ++i) {
+                occlusion.occluderVertices.push_back(glm::vec3(lines[bx + (i & 1)] - offset, (i & 4) ? top : floor,
+                                                               -(lines[bz + ((i >> 1) & 1)] - offset)));
+            }
+            // top, then the four sides, corners numbered x + 2 z + 4 top. triangles are
+            // wound to face out of the box so the rasterizer can skip its back
+            static const int faces[5][4] = { { 4, 5, 6, 7 }, { 0, 1, 4, 5 }, { 2, 3, 6, 7 }, { 0, 2, 4, 6 }, { 1, 3, 5, 7 } };
+            const glm::vec3* corner = &occlusion.occluderVertices[first];
+            glm::vec3 center = (corner[0] + corner[7]) * 0.5f;
+            for (const int* face : faces) {
+                for (int t = 0; t < 2; ++t) {
+                    int a = face[t], b = face[2], c = face[1 + 2 * t];
+                    glm::vec3 normal = glm::cross(corner[b] - corner[a], corner[c] - corner[a]);
+                    if (glm::dot(normal, corner[a] - center) < 0.0f) {
+                        std::swap(b, c);
+                    }
+                    occlusion.occluderIndices.insert(occlusion.occluderIndices.end(), { first + a, first + b, first + c });
+                }
+            }
+        }
+    }
+
+    occlusion.screenVertices.resize(occlusion.occluderVertices.size());
+    occlusion.clipped.resize(occlusion.occluderVertices.size());
+    for (std::vector<int>& bin : occlusion.bins) {
+        bin.reserve(occlusion.occluderIndices.size() / 3);
+    }
+
+    glm::ivec2 size(depthBufferWidth, depthBufferHeight);
+    while (true) {
+        occlusion.hiz.push_back(std::vector<float>(size.x * size.y, 1.0f));
+        occlusion.hizSize.push_back(size);
+        if (size.x == 1 && size.y == 1) {
+            break;
+        }
+        size = glm::ivec2((size.x + 1) / 2, (size.y + 1) / 2);
+    }
+    return occlusion;
+}
+
+// hiz texel (x, y) of level from the 2 x 2 texels below it, clamped at odd edges
+static void reduceTexel(DepthOcclusion& occlusion, int level, int x, int y) {
+    const std::vector<float>& below = occlusion.hiz[level - 1];
+    glm::ivec2 belowSize = occlusion.hizSize[level - 1];
+    int x0 = x * 2, y0 = y * 2;
+    int x1 = std::min(x0 + 1, belowSize.x - 1), y1 = std::min(y0 + 1, belowSize.y - 1);
+    occlusion.hiz[level][y * occlusion.hizSize[level].x + x] =
+        std::max(std::max(below[y0 * belowSize.x + x0], below[y0 * belowSize.x + x1]),
+                 std::max(below[y1 * belowSize.x + x0], below[y1 * belowSize.x + x1]));
+}
+
+// clears the tile, draws its triangles with four pixels per step and builds the
+// hiz levels that still fit inside the tile
+static void rasterizeTile(DepthOcclusion& occlusion, int tile) {
+    const int tileX0 = (tile % depthTilesX) * depthTileSize;
+    const int tileY0 = (tile / depthTilesX) * depthTileSize;
+    float* depth = occlusion.hiz[0].data();
+
+    for (int y = tileY0; y < tileY0 + depthTileSize; ++y) {
+        std::fill(depth + y * depthBufferWidth + tileX0, depth + y * depthBufferWidth + tileX0 + depthTileSize, 1.0f);
+    }
+
+    static const float laneCenters[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+    const f32x4 zero = splat4(0.0f);
+
+    for (int t : occlusion.bins[tile]) {
+        glm::vec3 a = occlusion.screenVertices[occlusion.occluderIndices[t * 3]];
+        glm::vec3 b = occlusion.screenVertices[occlusion.occluderIndices[t * 3 + 1]];
+        glm::vec3 c = occlusion.screenVertices[occlusion.occluderIndices[t * 3 + 2]];
+
+        // clockwise on screen faces away, the front of the same box is in front of it
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (area <= 0.0f) {
+            continue;
+        }
+
+        int minX = std::max(tileX0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+        int maxX = std::min(tileX0 + depthTileSize - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+        int minY = std::max(tileY0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+        int maxY = std::min(tileY0 + depthTileSize - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+        if (minX > maxX || minY > maxY) {
+            continue;
+        }
+        minX &= ~3;
+
+        // edge functions E(x, y) = A x + B y + C, positive inside. depth from the
+        // barycentrics of b and c, which are E_ca / area and E_ab / area. covered
+        // pixels get the farthest depth the triangle reaches inside them
+        auto edge = [](glm::vec3 p, glm::vec3 q, float& A, float& B, float& C) {
+            A = -(q.y - p.y);
+            B = q.x - p.x;
+            C = (q.y - p.y) * p.x - (q.x - p.x) * p.y;
+        };
+        float abA, abB, abC, bcA, bcB, bcC, caA, caB, caC;
+        edge(a, b, abA, abB, abC);
+        edge(b, c, bcA, bcB, bcC);
+        edge(c, a, caA, caB, caC);
+
+        float dzdx = ((b.z - a.z) * caA + (c.z - a.z) * abA) / area;
+        float dzdy = ((b.z - a.z) * caB + (c.z - a.z) * abB) / area;
+        f32x4 depthB = splat4((b.z - a.z) / area);
+        f32x4 depthC = splat4((c.z - a.z) / area);
+        f32x4 depthA = splat4(a.z + 0.5f * (std::abs(dzdx) + std::abs(dzdy)));
+
+        for (int y = minY; y <= maxY; ++y) {
+            float py = y + 0.5f;
+            float* row = depth + y * depthBufferWidth;
+            for (int x = minX; x <= maxX; x += 4) {
+                f32x4 px = splat4((float)x) + load4(laneCenters);
+                f32x4 eab = splat4(abA) * px + splat4(abB * py + abC);
+                f32x4 ebc = splat4(bcA) * px + splat4(bcB * py + bcC);
+                f32x4 eca = splat4(caA) * px + splat4(caB * py + caC);
+
+                f32x4 z = depthA + eca * depthB + eab * depthC;
+                f32x4 outside = less4(min4(eab, min4(ebc, eca)), zero);
+                f32x4 current = load4(row + x);
+                store4(row + x, select4(outside, current, min4(current, z)));
+            }
+        }
+    }
+
+    for (int level = 1; (depthTileSize >> level) >= 1; ++level) {
+        int size = depthTileSize >> level;
+        for (int y = tileY0 >> level; y < (tileY0 >> level) + size; ++y) {
+            for (int x = tileX0 >> level; x < (tileX0 >> level) + size; ++x) {
+                reduceTexel(occlusion, level, x, y);
+            }
+        }
+    }
+}
+
+// projects the occluders, bins their triangles by tile and rasterizes the tiles across the
+// workers. all of it runs inside the job, the thread that started it is free meanwhile
+static void rasterizeOccluders(void* context, int, int) {
+    DepthOcclusion& occlusion = *static_cast<DepthOcclusion*>(context);
+    const glm::mat4& viewProjection = occlusion.viewProjection;
+
+    for (size_t v = 0; v < occlusion.occluderVertices.size(); ++v) {
+        glm::vec4 clip = viewProjection * glm::vec4(occlusion.occluderVertices[v], 1.0f);
+        occlusion.clipped[v] = clip.w < depthNearW;
+        if (!occlusion.clipped[v]) {
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            occlusion.screenVertices[v] = glm::vec3((ndc.x * 0.5f + 0.5f) * depthBufferWidth,
+                                                    (ndc.y * 0.5f + 0.5f) * depthBufferHeight, ndc.z);
+        }
+    }
+
+    // triangles reaching behind the near plane are left out, that only loses occlusion
+    for (std::vector<int>& bin : occlusion.bins) {
+        bin.clear();
+    }
+    int triangleCount = static_cast<int>(occlusion.occluderIndices.size()) / 3;
+    for (int t = 0; t < triangleCount; ++t) {
+        const int* index = &occlusion.occluderIndices[t * 3];
+        if (occlusion.clipped[index[0]] || occlusion.clipped[index[1]] || occlusion.clipped[index[2]]) {
+            continue;
+        }
+        glm::vec3 a = occlusion.screenVertices[index[0]];
+        glm::vec3 b = occlusion.screenVertices[index[1]];
+        glm::vec3 c = occlusion.screenVertices[index[2]];
+        int tileMinX = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))) / depthTileSize);
+        int tileMaxX = std::min(depthTilesX - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))) / depthTileSize);
+        int tileMinY = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))) / depthTileSize);
+        int tileMaxY = std::min(depthTilesY - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))) / depthTileSize);
+        for (int ty = tileMinY; ty <= tileMaxY; ++ty) {
+            for (int tx = tileMinX; tx <= tileMaxX; ++tx) {
+                occlusion.bins[ty * depthTilesX + tx].push_back(t);
+            }
+        }
+    }
+
+    parallelFor(depthTilesX * depthTilesY, 1, [&](int begin, int end) {
+        for (int tile = begin; tile < end; ++tile) {
+            rasterizeTile(occlusion, tile);
+        }
+    });
+}
+
+void rasterizeOccludersAsync(DepthOcclusion& occlusion, const glm::mat4& viewProjection) {
+    if (occlusion.started) {
+        waitForJob(*occlusion.job); // the buffers are about to be reused
+    }
+    occlusion.viewProjection = viewProjection;
+    occlusion.started = true;
+    occlusion.resolved = false;
+
+    Job& job = *occlusion.job;
+    job.run = rasterizeOccluders;
+    job.context = &occlusion;
+    job.count = 1;
+    job.grain = 1;
+    job.next = 0;
+    job.finished = 0;
+    submitJob(job);
+}
+
+void waitForOccluders(DepthOcclusion& occlusion) {
+    if (!occlusion.started || occlusion.resolved) {
+        return;
+    }
+    waitForJob(*occlusion.job);
+
+    // levels above the tiles are cheap enough for this thread
+    int tileLevels = 0;
+    while ((depthTileSize >> tileLevels) > 1) {
+        ++tileLevels;
+    }
+    for (int level = tileLevels + 1; level < (int)occlusion.hiz.size(); ++level) {
+        for (int y = 0; y < occlusion.hizSize[level].y; ++y) {
+            for (int x = 0; x < occlusion.hizSize[level].x; ++x) {
+                reduceTexel(occlusion, level, x, y);
+            }
+        }
+    }
+    occlusion.resolved = true;
+}
+
+// true when the box is behind the occluders everywhere it covers on screen
+static bool boxOccluded(const DepthOcclusion& occlusion, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    glm::vec2 screenMin(1e30f), screenMax(-1e30f);
+    float nearest = 1e30f;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+        glm::vec4 clip = occlusion.viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w < depthNearW) {
+            return false;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen((ndc.x * 0.5f + 0.5f) * depthBufferWidth, (ndc.y * 0.5f + 0.5f) * depthBufferHeight);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        nearest = std::min(nearest, ndc.z);
+    }
+
+    int x0 = std::max(0, (int)std::floor(screenMin.x));
+    int y0 = std::max(0, (int)std::floor(screenMin.y));
+    int x1 = std::min(depthBufferWidth - 1, (int)std::floor(screenMax.x));
+    int y1 = std::min(depthBufferHeight - 1, (int)std::floor(screenMax.y));
+    if (x0 > x1 || y0 > y1) {
+        return false;
+    }
+
+    // a level where the box covers at most 4 x 4 texels
+    int level = 0;
+    while (level + 1 < (int)occlusion.hiz.size() && std::max((x1 >> level) - (x0 >> level), (y1 >> level) - (y0 >> level)) > 3) {
+        ++level;
+    }
+    const std::vector<float>& hiz = occlusion.hiz[level];
+    int width = occlusion.hizSize[level].x;
+    for (int y = y0 >> level; y <= y1 >> level; ++y) {
+        for (int x = x0 >> level; x <= x1 >> level; ++x) {
+            if (hiz[y * width + x] >= nearest) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void prepareOcclusionTests(DepthOcclusion& occlusion, const glm::mat4& viewProjection) {
+    if (!occlusion.started || occlusion.viewProjection != viewProjection) {
+        rasterizeOccludersAsync(occlusion, viewProjection);
+    }
+    waitForOccluders(occlusion);
+}
+
+int cullOccludedBoxes(DepthOcclusion& occlusion, const glm::mat4& viewProjection, const BoxList& boxes, unsigned char* visible) {
+    prepareOcclusionTests(occlusion, viewProjection);
+    return cullOccludedRange(occlusion, boxes, visible, 0, boxes.count);
+}
+
+int cullOccludedRange(const DepthOcclusion& occlusion, const BoxList& boxes, unsigned char* visible, int begin, int end) {
+    int culled = 0;
+    for (int i = begin; i < end; ++i) {
+        if (!visible[i]) {
+            continue;
+        }
+        glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        glm::vec3 extent(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+        if (boxOccluded(occlusion, center - extent, center + extent)) {
+            visible[i] = 0;
+            culled++;
+        }
+    }
+    return culled;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "frustum.h"
+#include "jobSystem.h"
+
+// low resolution software depth buffer of coarse terrain occluders, rasterized on the
+// worker threads one screen tile per job range, plus a max depth pyramid (hierarchical Z)
+// to test bounding boxes against. the occluders are boxes under the lowest point of
+// small blocks of the height map, so whatever they hide is really hidden
+const int depthBufferWidth = 256;
+const int depthBufferHeight = 192;
+const int depthTileSize = 32; // tiles are rasterized independently
+const int depthTilesX = depthBufferWidth / depthTileSize;
+const int depthTilesY = depthBufferHeight / depthTileSize;
+const int depthOccluderStep = 4; // occluder block size in height map quads
+
+struct DepthOcclusion {
+    std::vector<glm::vec3> occluderVertices; // world space
+    std::vector<int> occluderIndices;
+
+    // per frame
+    glm::mat4 viewProjection;
+    std::vector<glm::vec3> screenVertices; // pixels and NDC depth
+    std::vector<unsigned char> clipped;    // vertex too close to or behind the camera
+    std::vector<int> bins[depthTilesX * depthTilesY]; // triangles touching each tile
+
+    // level 0 is the depth buffer, every level above keeps the farthest depth of 2 x 2 texels
+    std::vector<std::vector<float>> hiz;
+    std::vector<glm::ivec2> hizSize;
+
+    std::unique_ptr<Job> job; // Job can't be moved, this keeps DepthOcclusion movable
+    bool started = false;
+    bool resolved = false;    // waited for and top hiz levels built
+};
+
+DepthOcclusion createDepthOcclusion();
+// starts projecting, binning and rasterizing the occluders for viewProjection on the worker
+// threads and returns at once, the caller can swap buffers or issue draw calls meanwhile
+void rasterizeOccludersAsync(DepthOcclusion& occlusion, const glm::mat4& viewProjection);
+// blocks until the last rasterization is done, also before the buffers go away
+void waitForOccluders(DepthOcclusion& occlusion);
+// clears visible[i] for every visible box hidden behind the occluders, returns how many.
+// waits for the rasterizer, which is started here if it didn't run for viewProjection
+int cullOccludedBoxes(DepthOcclusion& occlusion, const glm::mat4& viewProjection, const BoxList& boxes, unsigned char* visible);
+// the waiting half of cullOccludedBoxes. afterwards the buffers are only read, so
+// cullOccludedRange can test ranges of boxes on several threads at once
+void prepareOcclusionTests(DepthOcclusion& occlusion, const glm::mat4& viewProjection);
+int cullOccludedRange(const DepthOcclusion& occlusion, const BoxList& boxes, unsigned char* visible, int begin, int end);
@@ -0,0 +1,98 @@
+#include "frustum.h"
+#include "simd.h"
+#include <cmath>
+
+// Gribb/Hartmann plane extraction from the combined projection * view matrix
+Frustum extractFrustumPlanes(const glm::mat4& viewProjection) {
+    // glm is column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) {
+        row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = row[3] + row[0]; // left
+    frustum.planes[1] = row[3] - row[0]; // right
+    frustum.planes[2] = row[3] + row[1]; // bottom
+    frustum.planes[3] = row[3] - row[1]; // top
+    frustum.planes[4] = row[3] + row[2]; // near
+    frustum.planes[5] = row[3] - row[2]; // far
+
+    for (glm::vec4& plane : frustum.planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        plane /= length;
+    }
+    return frustum;
+}
+
+void addBox(BoxList& boxes, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+    int index = boxes.count++;
+    int padded = (boxes.count + 3) & ~3;
+
+    // padding lanes hold empty boxes at the origin, their result is never read
+    boxes.centerX.resize(padded, 0.0f);
+    boxes.centerY.resize(padded, 0.0f);
+    boxes.centerZ.resize(padded, 0.0f);
+    boxes.extentX.resize(padded, 0.0f);
+    boxes.extentY.resize(padded, 0.0f);
+    boxes.extentZ.resize(padded, 0.0f);
+
+    boxes.centerX[index] = center.x;
+    boxes.centerY[index] = center.y;
+    boxes.centerZ[index] = center.z;
+    boxes.extentX[index] = extent.x;
+    boxes.extentY[index] = extent.y;
+    boxes.extentZ[index] = extent.z;
+}
+
+// single box version of cullBoxes, for hierarchies that are walked one node at a time
+bool boxInFrustum(const Frustum& frustum, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+    for (const glm::vec4& plane : frustum.planes) {
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float radius = extent.x * std::abs(plane.x) + extent.y * std::abs(plane.y) + extent.z * std::abs(plane.z);
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// tests four boxes per iteration: a box is outside when its center lies further
+// behind any plane than the projection of its extents onto that plane's normal
+void cullBoxes(const Frustum& frustum, const BoxList& boxes, unsigned char* visible) {
+    cullBoxes(frustum, boxes, visible, 0, boxes.count);
+}
+
+void cullBoxes(const Frustum& frustum, const BoxList& boxes, unsigned char* visible, int begin, int end) {
+    const f32x4 zero = splat4(0.0f);
+
+    for (int i = begin; i < end; i += 4) {
+        f32x4 cx = load4(&boxes.centerX[i]);
+        f32x4 cy = load4(&boxes.centerY[i]);
+        f32x4 cz = load4(&boxes.centerZ[i]);
+        f32x4 ex = load4(&boxes.extentX[i]);
+        f32x4 ey = load4(&boxes.extentY[i]);
+        f32x4 ez = load4(&boxes.extentZ[i]);
+
+        int outside = 0;
+        for (const glm::vec4& plane : frustum.planes) {
+            f32x4 nx = splat4(plane.x);
+            f32x4 ny = splat4(plane.y);
+            f32x4 nz = splat4(plane.z);
+
+            f32x4 distance = cx * nx + cy * ny + cz * nz + splat4(plane.w);
+            f32x4 radius = ex * abs4(nx) + ey * abs4(ny) + ez * abs4(nz);
+            outside |= lessMask4(distance + radius, zero);
+        }
+
+        for (int lane = 0; lane < 4 && i + lane < end; ++lane) {
+            visible[i + lane] = (outside & (1 << lane)) ? 0 : 1;
+        }
+    }
+}
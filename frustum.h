@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// six planes (left, right, bottom, top, near, far) as (normal, distance),
+// pointing inwards so that dot(normal, p) + distance >= 0 means inside
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// axis aligned boxes stored as centers and half extents, one array per component,
+// padded to a multiple of 4 so the culling loop can always read whole vectors
+struct BoxList {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    int count = 0;
+};
+
+Frustum extractFrustumPlanes(const glm::mat4& viewProjection);
+void addBox(BoxList& boxes, glm::vec3 boundsMin, glm::vec3 boundsMax);
+bool boxInFrustum(const Frustum& frustum, glm::vec3 boundsMin, glm::vec3 boundsMax);
+// writes 1 to visible[i] when box i intersects the frustum, 0 otherwise
+void cullBoxes(const Frustum& frustum, const BoxList& boxes, unsigned char* visible);
+// same for boxes [begin, end), begin a multiple of 4. ranges may run on different threads
+void cullBoxes(const Frustum& frustum, const BoxList& boxes, unsigned char* visible, int begin, int end);
@@ -0,0 +1,199 @@
+#include "geomipTerrain.h"
+#include "glState.h"
+#include "jobSystem.h"
+#include "renderStats.h"
+#include "terrainGrid.h"
+#include "vertexCache.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// builds the triangles of one chunk at the given level. vertices on an edge whose
+// neighbour is coarser are snapped onto the neighbour's vertices, which turns the
+// edge into the coarse edge and leaves no T-junctions
+static void buildLevelIndices(int level, int mask, std::vector<unsigned short>& indices) {
+    int step = 1 << level;
+    int cells = chunkQuads / step;
+
+    auto vertex = [&](int i, int j) {
+        if (cells > 1) {
+            if ((mask & GeomipWest) && i == 0 && (j & 1)) --j;
+            if ((mask & GeomipEast) && i == cells && (j & 1)) --j;
+            if ((mask & GeomipNorth) && j == 0 && (i & 1)) --i;
+            if ((mask & GeomipSouth) && j == cells && (i & 1)) --i;
+        }
+        return static_cast<unsigned short>(gridIndex(i * step, j * step));
+    };
+
+    auto triangle = [&](unsigned short a, unsigned short b, unsigned short c) {
+        // snapping collapses some triangles, there is no point drawing them
+        if (a == b || b == c || a == c) return;
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    };
+
+    for (int j = 0; j < cells; ++j) {
+        for (int i = 0; i < cells; ++i) {
+            unsigned short a = vertex(i, j);
+            unsigned short b = vertex(i + 1, j);
+            unsigned short c = vertex(i, j + 1);
+            unsigned short d = vertex(i + 1, j + 1);
+            triangle(a, c, b);
+            triangle(b, c, d);
+        }
+    }
+}
+
+// max vertical distance between the full resolution heights of a chunk and the
+// triangles of the given level (same b-c diagonal as buildLevelIndices)
+static float computeLevelError(const TerrainChunk& chunk, int level) {
+    int step = 1 << level;
+    float maxError = 0.0f;
+
+    for (int z = chunk.z0; z <= chunk.z0 + chunkQuads; ++z) {
+        for (int x = chunk.x0; x <= chunk.x0 + chunkQuads; ++x) {
+            int cellX = std::min((x - chunk.x0) / step, chunkQuads / step - 1);
+            int cellZ = std::min((z - chunk.z0) / step, chunkQuads / step - 1);
+            int x0 = chunk.x0 + cellX * step;
+            int z0 = chunk.z0 + cellZ * step;
+            float u = (x - x0) / (float)step;
+            float v = (z - z0) / (float)step;
+
+            float a = gridHeight(x0, z0);
+            float b = gridHeight(x0 + step, z0);
+            float c = gridHeight(x0, z0 + step);
+            float d = gridHeight(x0 + step, z0 + step);
+
+            float approx = (u + v <= 1.0f)
+                ? a + u * (b - a) + v * (c - a)
+                : d + (1.0f - u) * (c - d) + (1.0f - v) * (b - d);
+            maxError = std::max(maxError, std::abs(gridHeight(x, z) - approx));
+        }
+    }
+    return maxError;
+}
+
+GeomipTerrain createGeomipTerrain(GLuint gridVBO, const TerrainChunkGrid& grid) {
+    GeomipTerrain terrain;
+    terrain.vbo = gridVBO;
+
+    // row by row order from buildLevelIndices is reordered for the vertex cache
+    std::vector<unsigned short> indices;
+    VertexCacheStats cacheBefore, cacheAfter;
+    for (int level = 0; level < geomipLevels; ++level) {
+        for (int mask = 0; mask < 16; ++mask) {
+            int offset = static_cast<int>(indices.size());
+            buildLevelIndices(level, mask, indices);
+            int count = static_cast<int>(indices.size()) - offset;
+
+            cacheBefore += simulateVertexCache(&indices[offset], count);
+            optimizeVertexCache(&indices[offset], count);
+            cacheAfter += simulateVertexCache(&indices[offset], count);
+
+            terrain.indexOffset[level][mask] = offset;
+            terrain.indexCount[level][mask] = count;
+        }
+    }
+    std::cout << "geomip vertex cache: ACMR " << cacheBefore.acmr() << " -> " << cacheAfter.acmr()
+              << ", vertex shader invocations " << cacheBefore.vertexShaderInvocations
+              << " -> " << cacheAfter.vertexShaderInvocations << std::endl;
+
+    glGenBuffers(1, &terrain.ibo);
+    terrain.vao = createTerrainGridVAO(gridVBO, terrain.ibo);
+    bindVertexArray(terrain.vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    bindVertexArray(0);
+
+    // errors never shrink with coarser levels, so level selection can stop at the first miss
+    terrain.levelError.resize(grid.chunks.size() * geomipLevels);
+    for (size_t c = 0; c < grid.chunks.size(); ++c) {
+        float error = 0.0f;
+        for (int level = 0; level < geomipLevels; ++level) {
+            error = std::max(error, computeLevelError(grid.chunks[c], level));
+            terrain.levelError[c * geomipLevels + level] = error;
+        }
+    }
+    terrain.chunkLevel.resize(grid.chunks.size(), 0);
+
+    return terrain;
+}
+
+// picks the coarsest level whose projected error stays under pixelTolerance, then
+// refines chunks until neighbours differ by at most one level so stitching works
+void selectGeomipLevels(GeomipTerrain& terrain, const TerrainChunkGrid& grid, const FrameCamera& camera) {
+    float pixelsPerUnit = camera.viewportHeight / (2.0f * std::tan(camera.fieldOfView * 0.5f));
+
+    // independent per chunk, only the neighbour fix-up below has to run in order
+    parallelFor(static_cast<int>(grid.chunks.size()), 16, [&](int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            const TerrainChunk& chunk = grid.chunks[c];
+            glm::vec3 closest = glm::clamp(camera.position, chunk.boundsMin, chunk.boundsMax);
+            float distance = std::max(glm::length(closest - camera.position), 0.001f);
+
+            int level = 0;
+            while (level + 1 < geomipLevels &&
+                   terrain.levelError[c * geomipLevels + level + 1] * pixelsPerUnit / distance <= terrain.pixelTolerance) {
+                ++level;
+            }
+            terrain.chunkLevel[c] = level;
+        }
+    });
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int cz = 0; cz < chunksPerSide; ++cz) {
+            for (int cx = 0; cx < chunksPerSide; ++cx) {
+                int& level = terrain.chunkLevel[cz * chunksPerSide + cx];
+                int limit = level;
+                if (cx > 0) limit = std::min(limit, terrain.chunkLevel[cz * chunksPerSide + cx - 1] + 1);
+                if (cx + 1 < chunksPerSide) limit = std::min(limit, terrain.chunkLevel[cz * chunksPerSide + cx + 1] + 1);
+                if (cz > 0) limit = std::min(limit, terrain.chunkLevel[(cz - 1) * chunksPerSide + cx] + 1);
+                if (cz + 1 < chunksPerSide) limit = std::min(limit, terrain.chunkLevel[(cz + 1) * chunksPerSide + cx] + 1);
+                if (limit != level) {
+                    level = limit;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void submitGeomipTerrain(RenderQueue& queue, GLuint shaderProgram, GLuint texture, GeomipTerrain& terrain, TerrainChunkGrid& grid, const FrameCamera& camera) {
+    cullTerrainChunks(grid, camera);
+    selectGeomipLevels(terrain, grid, camera);
+
+    auto levelAt = [&](int cx, int cz) {
+        return terrain.chunkLevel[cz * chunksPerSide + cx];
+    };
+
+    // one command list per row of chunks
+    recordParallel(queue, chunksPerSide, 1, [&](CommandList& list, int begin, int end) {
+        for (int cz = begin; cz < end; ++cz) {
+            for (int cx = 0; cx < chunksPerSide; ++cx) {
+                int c = cz * chunksPerSide + cx;
+                if (!grid.visible[c]) {
+                    list.stats.chunksCulled++;
+                    continue;
+                }
+
+                int level = terrain.chunkLevel[c];
+                int mask = 0;
+                if (cx > 0 && levelAt(cx - 1, cz) > level) mask |= GeomipWest;
+                if (cx + 1 < chunksPerSide && levelAt(cx + 1, cz) > level) mask |= GeomipEast;
+                if (cz > 0 && levelAt(cx, cz - 1) > level) mask |= GeomipNorth;
+                if (cz + 1 < chunksPerSide && levelAt(cx, cz + 1) > level) mask |= GeomipSouth;
+
+                const TerrainChunk& chunk = grid.chunks[c];
+                glm::vec3 center = 0.5f * (chunk.boundsMin + chunk.boundsMax);
+                DrawPacket packet = { shaderProgram, texture, terrain.vao, GL_TRIANGLES, GL_UNSIGNED_SHORT,
+                                      terrain.indexCount[level][mask], terrain.indexOffset[level][mask],
+                                      gridIndex(chunk.x0, chunk.z0) };
+                recordDraw(list, makeSortKey(RenderPassOpaque, shaderProgram, texture, terrain.vao,
+                                             glm::distance(center, camera.position)), packet);
+                list.stats.chunksSubmitted++;
+            }
+        }
+    });
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "camera.h"
+#include "renderQueue.h"
+#include "terrainChunks.h"
+
+// level l samples every 2^l-th vertex, the last level is a single quad per chunk
+const int geomipLevels = 6;
+static_assert((1 << (geomipLevels - 1)) == chunkQuads, "geomip levels must end at one quad per chunk");
+
+// neighbour bits of the stitching mask, set when that neighbour is one level coarser
+enum GeomipEdge {
+    GeomipWest = 1,  // x0 side
+    GeomipEast = 2,  // x1 side
+    GeomipNorth = 4, // z0 side
+    GeomipSouth = 8  // z1 side
+};
+
+struct GeomipTerrain {
+    GLuint vao, vbo, ibo;
+    // one shared index list per level and stitching mask, indices are relative to the chunk corner
+    int indexOffset[geomipLevels][16];
+    int indexCount[geomipLevels][16];
+    std::vector<float> levelError; // max vertical error, chunk * geomipLevels + level
+    std::vector<int> chunkLevel;
+    float pixelTolerance = 2.0f;
+};
+
+GeomipTerrain createGeomipTerrain(GLuint gridVBO, const TerrainChunkGrid& grid);
+void selectGeomipLevels(GeomipTerrain& terrain, const TerrainChunkGrid& grid, const FrameCamera& camera);
+void submitGeomipTerrain(RenderQueue& queue, GLuint shaderProgram, GLuint texture, GeomipTerrain& terrain, TerrainChunkGrid& grid, const FrameCamera& camera);
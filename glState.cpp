@@ -0,0 +1,120 @@
+#include "glState.h"
+#include "renderStats.h"
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+// nothing is assumed about the context until it was set through the cache once
+const GLuint unknownBinding = 0xFFFFFFFF;
+
+struct BufferRange {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+
+    bool operator==(const BufferRange& other) const {
+        return buffer == other.buffer && offset == other.offset && size == other.size;
+    }
+};
+
+struct GLStateCache {
+    GLuint program = unknownBinding;
+    GLuint vertexArray = unknownBinding;
+    int activeUnit = -1;
+    std::unordered_map<GLenum, GLuint> textures[glStateTextureUnits];
+    std::unordered_map<GLenum, GLuint> buffers;
+    std::unordered_map<GLuint, GLuint> elementBuffers; // by vertex array
+    std::map<std::pair<GLenum, GLuint>, BufferRange> bufferRanges; // by target and index
+    std::unordered_map<GLenum, bool> capabilities;
+};
+
+static GLStateCache state;
+
+// true when the call has to be issued, false when it was elided
+template <class Map>
+static bool update(Map& cache, const typename Map::key_type& key, const typename Map::mapped_type& value) {
+    auto inserted = cache.emplace(key, value);
+    if (!inserted.second && inserted.first->second == value) {
+        renderStats.glCallsElided++;
+        return false;
+    }
+    inserted.first->second = value;
+    renderStats.glCallsIssued++;
+    return true;
+}
+
+template <class Value>
+static bool update(Value& cached, Value value) {
+    if (cached == value) {
+        renderStats.glCallsElided++;
+        return false;
+    }
+    cached = value;
+    renderStats.glCallsIssued++;
+    return true;
+}
+
+void useProgram(GLuint program) {
+    if (update(state.program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void bindVertexArray(GLuint vao) {
+    if (update(state.vertexArray, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void activeTexture(int unit) {
+    if (update(state.activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void bindTexture(GLenum target, GLuint texture) {
+    if (state.activeUnit < 0 || state.activeUnit >= glStateTextureUnits) {
+        renderStats.glCallsIssued++;
+        glBindTexture(target, texture);
+        return;
+    }
+    if (update(state.textures[state.activeUnit], target, texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void bindBuffer(GLenum target, GLuint buffer) {
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        if (state.vertexArray == unknownBinding) {
+            renderStats.glCallsIssued++;
+            glBindBuffer(target, buffer);
+        } else if (update(state.elementBuffers, state.vertexArray, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+        return;
+    }
+    if (update(state.buffers, target, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    if (update(state.bufferRanges, std::make_pair(target, index), BufferRange{ buffer, offset, size })) {
+        glBindBufferRange(target, index, buffer, offset, size);
+        state.buffers[target] = buffer;
+    }
+}
+
+void setCapability(GLenum capability, bool enabled) {
+    if (update(state.capabilities, capability, enabled)) {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+}
+
+void resetGLState() {
+    state = GLStateCache();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// thin wrappers over the GL binding calls that remember what is bound and skip calls
+// that would not change anything. every binding in the renderer has to go through here,
+// a raw glBind* behind the cache's back leaves it out of date until resetGLState
+const int glStateTextureUnits = 16;
+
+void useProgram(GLuint program);
+void bindVertexArray(GLuint vao);
+// unit is an index (0, 1, ...) rather than GL_TEXTURE0 + index
+void activeTexture(int unit);
+// binds on the active unit, like glBindTexture
+void bindTexture(GLenum target, GLuint texture);
+// element array bindings are remembered per vertex array, as GL stores them there
+void bindBuffer(GLenum target, GLuint buffer);
+// glBindBufferRange, which also changes the target's generic binding
+void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+void setCapability(GLenum capability, bool enabled);
+
+// forgets everything, the next call for each binding is issued again
+void resetGLState();
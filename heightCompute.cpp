@@ -0,0 +1,78 @@
+#include "heightCompute.h"
+#include "glState.h"
+#include "heightTexture.h"
+#include "terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+const int heightComputeGroupSize = 8; // local_size_x and local_size_y of the shader
+
+bool heightComputeSupported() {
+    return GLEW_VERSION_4_3;
+}
+
+HeightCompute createHeightCompute(const char* computeSource) {
+    HeightCompute compute;
+    compute.shader = createComputeProgram(computeSource);
+    compute.controlTexture = 0;
+
+    int linked;
+    glGetProgramiv(compute.shader.program, GL_LINK_STATUS, &linked);
+    compute.linked = linked != 0;
+    if (!compute.linked) {
+        return compute;
+    }
+
+    compute.controlTexture = createControlTexture();
+
+    useProgram(compute.shader.program);
+    setUniform(findUniform<int>(compute.shader, "controlSampler"), 0);
+    setUniform(findUniform<int>(compute.shader, "heightImage"), 0);
+    setUniform(findUniform<int>(compute.shader, "fineSize"), fineSize);
+    setUniform(findUniform<int>(compute.shader, "controlSize"), controlSize);
+
+    return compute;
+}
+
+void destroyHeightCompute(HeightCompute& compute) {
+    glDeleteProgram(compute.shader.program);
+    glDeleteTextures(1, &compute.controlTexture);
+    compute.shader.program = 0;
+    compute.controlTexture = 0;
+    compute.linked = false;
+}
+
+void generateHeightsOnGpu(HeightCompute& compute, GLuint heightTexture) {
+    updateControlTexture(compute.controlTexture);
+    activeTexture(0);
+    bindTexture(GL_TEXTURE_2D, compute.controlTexture);
+
+    useProgram(compute.shader.program);
+    glBindImageTexture(0, heightTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    int groups = (fineSize + heightComputeGroupSize - 1) / heightComputeGroupSize;
+    glDispatchCompute(groups, groups, 1);
+
+    // later draws sample the texture, validation reads it back
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+float compareHeightsWithCpu(GLuint heightTexture) {
+    std::vector<float> heights(fineSize * fineSize);
+    bindTexture(GL_TEXTURE_2D, heightTexture);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, heights.data());
+    bindTexture(GL_TEXTURE_2D, 0);
+
+    float maxDifference = 0.0f;
+    for (int z = 0; z < fineSize; ++z) {
+        for (int x = 0; x < fineSize; ++x) {
+            float difference = std::abs(heights[z * fineSize + x] - heightMap[z][x]);
+            // NaN must fail the check too
+            if (!(difference <= maxDifference)) {
+                maxDifference = std::isnan(difference) ? INFINITY : difference;
+            }
+        }
+    }
+    return maxDifference;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <GL/glew.h>
+#include "shaderProgram.h"
+
+// GL 4.3 path evaluating the Catmull-Rom surface of generateHeightMap on the GPU. only the
+// control points are uploaded, the fine heights are written straight into the height texture
+const float heightComputeTolerance = 1e-3f; // allowed difference to the CPU generator
+
+struct HeightCompute {
+    ShaderProgram shader;
+    GLuint controlTexture; // R32F, texel (x, z) is controlPoints[z][x]
+    bool linked;           // false when the driver rejected the shader, heights must come from the CPU
+};
+
+// the shader is #version 430, ARB_compute_shader alone on an older context can't compile it
+bool heightComputeSupported();
+HeightCompute createHeightCompute(const char* computeSource);
+void destroyHeightCompute(HeightCompute& compute);
+// uploads controlPoints and regenerates every texel of a createHeightTexture texture
+void generateHeightsOnGpu(HeightCompute& compute, GLuint heightTexture);
+// reads the texture back and returns the largest difference to heightMap
+float compareHeightsWithCpu(GLuint heightTexture);
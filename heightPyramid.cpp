@@ -0,0 +1,53 @@
+#include "heightPyramid.h"
+#include <algorithm>
+
+HeightPyramid buildHeightPyramid() {
+    HeightPyramid pyramid;
+    pyramid.size = 1;
+    while (pyramid.size < fineSize - 1) {
+        pyramid.size *= 2;
+    }
+
+    int size = pyramid.size;
+    while (size >= 1) {
+        pyramid.levels++;
+        size /= 2;
+    }
+    pyramid.minMax.resize(pyramid.levels);
+
+    // quads past the edge of the map repeat the last row/column
+    auto height = [](int x, int z) {
+        return heightMap[std::min(z, fineSize - 1)][std::min(x, fineSize - 1)];
+    };
+
+    std::vector<glm::vec2>& base = pyramid.minMax[0];
+    base.resize(pyramid.size * pyramid.size);
+    for (int z = 0; z < pyramid.size; ++z) {
+        for (int x = 0; x < pyramid.size; ++x) {
+            float h00 = height(x, z);
+            float h10 = height(x + 1, z);
+            float h01 = height(x, z + 1);
+            float h11 = height(x + 1, z + 1);
+            base[z * pyramid.size + x] = glm::vec2(std::min(std::min(h00, h10), std::min(h01, h11)),
+                                                   std::max(std::max(h00, h10), std::max(h01, h11)));
+        }
+    }
+
+    for (int level = 1; level < pyramid.levels; ++level) {
+        int levelSize = pyramid.size >> level;
+        std::vector<glm::vec2>& current = pyramid.minMax[level];
+        current.resize(levelSize * levelSize);
+        for (int z = 0; z < levelSize; ++z) {
+            for (int x = 0; x < levelSize; ++x) {
+                glm::vec2 a = pyramid.at(level - 1, x * 2, z * 2);
+                glm::vec2 b = pyramid.at(level - 1, x * 2 + 1, z * 2);
+                glm::vec2 c = pyramid.at(level - 1, x * 2, z * 2 + 1);
+                glm::vec2 d = pyramid.at(level - 1, x * 2 + 1, z * 2 + 1);
+                current[z * levelSize + x] = glm::vec2(std::min(std::min(a.x, b.x), std::min(c.x, d.x)),
+                                                       std::max(std::max(a.y, b.y), std::max(c.y, d.y)));
+            }
+        }
+    }
+
+    return pyramid;
+}
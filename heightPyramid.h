@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "terrain.h"
+
+// min (x) and max (y) height over power of two blocks of height map quads.
+// level 0 holds single quads, every level above halves the resolution
+struct HeightPyramid {
+    int size = 0;   // quads per side at level 0, the smallest power of two covering the map
+    int levels = 0;
+    std::vector<std::vector<glm::vec2>> minMax; // [level][z * (size >> level) + x]
+
+    glm::vec2 at(int level, int x, int z) const {
+        return minMax[level][z * (size >> level) + x];
+    }
+};
+
+HeightPyramid buildHeightPyramid();
@@ -0,0 +1,44 @@
+#include "heightTexture.h"
+#include "glState.h"
+#include "terrain.h"
+
+GLuint createHeightTexture(bool upload) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, fineSize, fineSize, 0, GL_RED, GL_FLOAT, upload ? heightMap : nullptr);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    bindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// re-uploads heightMap after it was regenerated
+void updateHeightTexture(GLuint texture) {
+    bindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fineSize, fineSize, GL_RED, GL_FLOAT, heightMap);
+    bindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLuint createControlTexture() {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, controlSize, controlSize, 0, GL_RED, GL_FLOAT, controlPoints);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    bindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void updateControlTexture(GLuint texture) {
+    bindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, controlSize, controlSize, GL_RED, GL_FLOAT, controlPoints);
+    bindTexture(GL_TEXTURE_2D, 0);
+}
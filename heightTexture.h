@@ -0,0 +1,14 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// single channel float texture holding heightMap, for renderers that displace in the vertex shader.
+// texel (x, z) is heightMap[z][x], filtering is linear and coordinates clamp at the edges.
+// without upload the storage is left undefined for generateHeightsOnGpu to fill
+GLuint createHeightTexture(bool upload = true);
+void updateHeightTexture(GLuint texture);
+
+// controlPoints as an R32F texture for shaders that evaluate the spline themselves.
+// texel (x, z) is controlPoints[z][x], fetched with texelFetch so filtering is nearest
+GLuint createControlTexture();
+void updateControlTexture(GLuint texture);
@@ -0,0 +1,141 @@
+#include "horizonCulling.h"
+#include <algorithm>
+#include <cmath>
+
+const float pi = 3.14159265358979f;
+
+HorizonCuller createHorizonCuller(const HeightPyramid& pyramid, int level) {
+    HorizonCuller culler;
+    culler.horizon.resize(horizonColumns);
+
+    // same placement as createTexturedTerrainVAO, blocks past the map are left out
+    float offset = fineSize / 2.0f;
+    int block = 1 << level;
+    int blocksPerSide = pyramid.size >> level;
+    for (int z = 0; z < blocksPerSide && z * block < fineSize - 1; ++z) {
+        for (int x = 0; x < blocksPerSide && x * block < fineSize - 1; ++x) {
+            int x1 = std::min((x + 1) * block, fineSize - 1);
+            int z1 = std::min((z + 1) * block, fineSize - 1);
+
+            HorizonOccluder occluder;
+            occluder.rectMin = glm::vec2(x * block - offset, -(z1 - offset));
+            occluder.rectMax = glm::vec2(x1 - offset, -(z * block - offset));
+            occluder.height = pyramid.at(level, x, z).x;
+            culler.occluders.push_back(occluder);
+        }
+    }
+
+    culler.occluderOrder.reserve(culler.occluders.size());
+    return culler;
+}
+
+// columns a rectangle spans seen from eye, as a fractional range that may run past
+// either end of [0, horizonColumns) and wraps. false when eye is inside the rectangle
+static bool rectColumns(glm::vec2 eye, glm::vec2 rectMin, glm::vec2 rectMax,
+                        float& first, float& last, float& nearest, float& farthest) {
+    if (eye.x >= rectMin.x && eye.x <= rectMax.x && eye.y >= rectMin.y && eye.y <= rectMax.y) {
+        return false;
+    }
+
+    // angles relative to the centre direction so the range never straddles +-pi
+    glm::vec2 toCenter = (rectMin + rectMax) * 0.5f - eye;
+    float center = std::atan2(toCenter.y, toCenter.x);
+    float low = 0.0f, high = 0.0f;
+    farthest = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        glm::vec2 corner((i & 1) ? rectMax.x : rectMin.x, (i & 2) ? rectMax.y : rectMin.y);
+        glm::vec2 d = corner - eye;
+        float angle = std::atan2(d.y, d.x) - center;
+        if (angle > pi) angle -= 2.0f * pi;
+        if (angle < -pi) angle += 2.0f * pi;
+        low = std::min(low, angle);
+        high = std::max(high, angle);
+        farthest = std::max(farthest, glm::length(d));
+    }
+    nearest = glm::length(glm::clamp(eye, rectMin, rectMax) - eye);
+
+    const float columnsPerRadian = horizonColumns / (2.0f * pi);
+    first = (center + low + pi) * columnsPerRadian;
+    last = (center + high + pi) * columnsPerRadian;
+    return true;
+}
+
+static int wrapColumn(int column) {
+    return ((column % horizonColumns) + horizonColumns) % horizonColumns;
+}
+
+// raises the columns completely covered by the occluder. every ray in those columns
+// crosses the rectangle somewhere between nearest and farthest, where the terrain is at
+// least height, so the lowest slope it can give is taken: over nearest when the block
+// is below the eye, rays leaving through a side may cross it well before farthest
+static void addOccluder(HorizonCuller& culler, const HorizonOccluder& occluder, glm::vec3 eye) {
+    float first, last, nearest, farthest;
+    if (!rectColumns(glm::vec2(eye.x, eye.z), occluder.rectMin, occluder.rectMax, first, last, nearest, farthest)) {
+        return;
+    }
+    float rise = occluder.height - eye.y;
+    float slope = rise / (rise < 0.0f ? std::max(nearest, 1e-3f) : farthest);
+    for (int column = (int)std::ceil(first); column + 1 <= (int)std::floor(last); ++column) {
+        float& horizon = culler.horizon[wrapColumn(column)];
+        horizon = std::max(horizon, slope);
+    }
+}
+
+int cullBelowHorizon(HorizonCuller& culler, const BoxList& boxes, unsigned char* visible, glm::vec3 cameraPosition) {
+    glm::vec2 eye(cameraPosition.x, cameraPosition.z);
+    std::fill(culler.horizon.begin(), culler.horizon.end(), -1e30f);
+
+    culler.occluderOrder.clear();
+    for (int i = 0; i < (int)culler.occluders.size(); ++i) {
+        const HorizonOccluder& occluder = culler.occluders[i];
+        glm::vec2 farCorner = glm::max(glm::abs(occluder.rectMin - eye), glm::abs(occluder.rectMax - eye));
+        culler.occluderOrder.push_back({ glm::length(farCorner), i });
+    }
+    std::sort(culler.occluderOrder.begin(), culler.occluderOrder.end());
+
+    culler.boxOrder.clear();
+    for (int i = 0; i < boxes.count; ++i) {
+        if (!visible[i]) {
+            continue;
+        }
+        glm::vec2 center(boxes.centerX[i], boxes.centerZ[i]);
+        glm::vec2 extent(boxes.extentX[i], boxes.extentZ[i]);
+        float nearest = glm::length(glm::clamp(eye, center - extent, center + extent) - eye);
+        culler.boxOrder.push_back({ nearest, i });
+    }
+    std::sort(culler.boxOrder.begin(), culler.boxOrder.end());
+
+    // front to back: before a box is tested, every occluder lying entirely closer than
+    // the box goes into the horizon, so nothing behind the box can hide it
+    int culled = 0;
+    size_t nextOccluder = 0;
+    for (const std::pair<float, int>& entry : culler.boxOrder) {
+        while (nextOccluder < culler.occluderOrder.size() && culler.occluderOrder[nextOccluder].first <= entry.first) {
+            addOccluder(culler, culler.occluders[culler.occluderOrder[nextOccluder].second], cameraPosition);
+            ++nextOccluder;
+        }
+
+        int i = entry.second;
+        glm::vec2 center(boxes.centerX[i], boxes.centerZ[i]);
+        glm::vec2 extent(boxes.extentX[i], boxes.extentZ[i]);
+        float first, last, nearest, farthest;
+        if (!rectColumns(eye, center - extent, center + extent, first, last, nearest, farthest)) {
+            continue;
+        }
+
+        // steepest slope anywhere in the box: its top at the closest point when above
+        // the camera, at the farthest point when below
+        float top = boxes.centerY[i] + boxes.extentY[i] - cameraPosition.y;
+        float slope = top / (top > 0.0f ? std::max(nearest, 1e-3f) : farthest);
+
+        bool hidden = true;
+        for (int column = (int)std::floor(first); column <= (int)std::floor(last) && hidden; ++column) {
+            hidden = culler.horizon[wrapColumn(column)] > slope;
+        }
+        if (hidden) {
+            visible[i] = 0;
+            culled++;
+        }
+    }
+    return culled;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+#include "frustum.h"
+#include "heightPyramid.h"
+
+// occlusion horizon (Downs et al.) for a height field: the steepest slope seen so far
+// in every azimuth column around the camera. occluders are blocks of the min/max
+// pyramid at their min height, swept front to back, and a box whose highest point
+// stays under the horizon in every column it covers can't be seen
+const int horizonColumns = 1024;       // columns over the full circle around the camera
+const int horizonOccluderLevel = 2;    // pyramid level used as occluders, 4 x 4 quads
+
+// block of terrain that is at least height high everywhere inside its xz rectangle
+struct HorizonOccluder {
+    glm::vec2 rectMin, rectMax; // world x and z
+    float height;
+};
+
+struct HorizonCuller {
+    std::vector<HorizonOccluder> occluders;
+    std::vector<float> horizon; // slope (dy / horizontal distance) per column
+
+    // per frame scratch, sorted by distance from the camera
+    std::vector<std::pair<float, int>> occluderOrder;
+    std::vector<std::pair<float, int>> boxOrder;
+};
+
+HorizonCuller createHorizonCuller(const HeightPyramid& pyramid, int level);
+// clears visible[i] for every box that is visible now but hidden behind the terrain,
+// returns how many were cleared
+int cullBelowHorizon(HorizonCuller& culler, const BoxList& boxes, unsigned char* visible, glm::vec3 cameraPosition);
@@ -0,0 +1,127 @@
+#include "instancedTerrain.h"
+#include "glState.h"
+#include "renderStats.h"
+#include "terrainGrid.h"
+#include "vertexCache.h"
+#include <cstring>
+
+InstancedTerrain createInstancedTerrain(const ShaderProgram& shader, const TerrainChunkGrid& grid) {
+    InstancedTerrain terrain;
+    terrain.shaderProgram = shader.program;
+    int chunkCount = static_cast<int>(grid.chunks.size());
+    terrain.instances.reserve(chunkCount);
+
+    std::vector<glm::vec2> vertices;
+    for (int j = 0; j < instancePatchSize; ++j) {
+        for (int i = 0; i < instancePatchSize; ++i) {
+            vertices.push_back(glm::vec2((float)i, (float)j));
+        }
+    }
+
+    // same winding as the geomip chunks
+    std::vector<unsigned short> indices;
+    for (int j = 0; j < chunkQuads; ++j) {
+        for (int i = 0; i < chunkQuads; ++i) {
+            unsigned short a = j * instancePatchSize + i;
+            unsigned short b = a + 1;
+            unsigned short c = a + instancePatchSize;
+            unsigned short d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    terrain.indexCount = static_cast<int>(indices.size());
+    optimizeVertexCache(indices.data(), terrain.indexCount);
+
+    terrain.instanceStream = createStreamBuffer(GL_ARRAY_BUFFER, chunkCount * sizeof(glm::vec4));
+
+    glGenVertexArrays(1, &terrain.vao);
+    bindVertexArray(terrain.vao);
+
+    glGenBuffers(1, &terrain.vbo);
+    bindBuffer(GL_ARRAY_BUFFER, terrain.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &terrain.ibo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    // advanced once per instance, pointed at this frame's instances before the draw
+    bindBuffer(GL_ARRAY_BUFFER, terrain.instanceStream.buffer);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+
+    bindVertexArray(0);
+
+    // chunk c lives in layer c, padding vertices past the map edge repeat the edge like the grid VBO
+    std::vector<float> heights(instancePatchSize * instancePatchSize * chunkCount);
+    for (int c = 0; c < chunkCount; ++c) {
+        const TerrainChunk& chunk = grid.chunks[c];
+        float* layer = &heights[c * instancePatchSize * instancePatchSize];
+        for (int j = 0; j < instancePatchSize; ++j) {
+            for (int i = 0; i < instancePatchSize; ++i) {
+                layer[j * instancePatchSize + i] = gridHeight(chunk.x0 + i, chunk.z0 + j);
+            }
+        }
+    }
+
+    glGenTextures(1, &terrain.heightTexture);
+    bindTexture(GL_TEXTURE_2D_ARRAY, terrain.heightTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, instancePatchSize, instancePatchSize, chunkCount, 0,
+                 GL_RED, GL_FLOAT, heights.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    useProgram(shader.program);
+    setUniform(findUniform<int>(shader, "textureSampler"), 0);
+    setUniform(findUniform<int>(shader, "heightSampler"), 1);
+    setUniform(findUniform<float>(shader, "mapSize"), (float)fineSize);
+
+    return terrain;
+}
+
+void drawInstancedTerrain(InstancedTerrain& terrain, GLuint texture, TerrainChunkGrid& grid, const FrameCamera& camera) {
+    cullTerrainChunks(grid, camera);
+
+    terrain.instances.clear();
+    for (size_t c = 0; c < grid.chunks.size(); ++c) {
+        if (!grid.visible[c]) {
+            renderStats.chunksCulled++;
+            continue;
+        }
+        const TerrainChunk& chunk = grid.chunks[c];
+        terrain.instances.push_back(glm::vec4((float)chunk.x0, (float)chunk.z0, (float)c, 0.0f));
+    }
+    if (terrain.instances.empty()) {
+        return;
+    }
+
+    beginStreamFrame(terrain.instanceStream);
+    GLsizeiptr size = terrain.instances.size() * sizeof(glm::vec4);
+    GLintptr offset = 0;
+    bindBuffer(GL_ARRAY_BUFFER, terrain.instanceStream.buffer);
+    void* destination = mapStreamRange(terrain.instanceStream, size, sizeof(glm::vec4), offset);
+    if (destination) {
+        std::memcpy(destination, terrain.instances.data(), size);
+        unmapStreamRange(terrain.instanceStream);
+
+        useProgram(terrain.shaderProgram); // camera matrices come from the shared Camera block
+        activeTexture(1);
+        bindTexture(GL_TEXTURE_2D_ARRAY, terrain.heightTexture);
+        activeTexture(0);
+        bindTexture(GL_TEXTURE_2D, texture);
+
+        bindVertexArray(terrain.vao);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)offset);
+        glDrawElementsInstanced(GL_TRIANGLES, terrain.indexCount, GL_UNSIGNED_SHORT, (void*)0,
+                                (GLsizei)terrain.instances.size());
+
+        renderStats.drawCalls++;
+        renderStats.chunksSubmitted += static_cast<int>(terrain.instances.size());
+        renderStats.trianglesDrawn += (long long)terrain.instances.size() * terrain.indexCount / 3;
+    }
+    endStreamFrame(terrain.instanceStream);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "shaderProgram.h"
+#include "streamBuffer.h"
+#include "terrainChunks.h"
+
+// every visible chunk drawn in one glDrawElementsInstanced of a single chunk sized grid
+// patch. the patch only holds grid positions, heights come from a texture array with
+// one layer per chunk and each instance says which chunk and layer it is
+const int instancePatchSize = chunkQuads + 1; // vertices per side, also the layer size
+
+struct InstancedTerrain {
+    GLuint shaderProgram;
+    GLuint vao, vbo, ibo;
+    int indexCount;
+    GLuint heightTexture; // GL_TEXTURE_2D_ARRAY, instancePatchSize squared, one layer per chunk
+    StreamBuffer instanceStream;
+    std::vector<glm::vec4> instances; // x0, z0 in height map vertices, height layer, unused
+};
+
+InstancedTerrain createInstancedTerrain(const ShaderProgram& shader, const TerrainChunkGrid& grid);
+void drawInstancedTerrain(InstancedTerrain& terrain, GLuint texture, TerrainChunkGrid& grid, const FrameCamera& camera);
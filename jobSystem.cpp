@@ -0,0 +1,139 @@
+#include "jobSystem.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// jobs waiting for workers, a fixed ring so submitting never allocates
+const int maxQueuedJobs = 64;
+
+struct JobSystem {
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable jobDone;
+    Job* queue[maxQueuedJobs];
+    int queueStart = 0;
+    int queueSize = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    JobSystem();
+    ~JobSystem();
+    void removeFromQueue(Job* job);
+};
+
+static JobSystem& jobSystem() {
+    static JobSystem system;
+    return system;
+}
+
+// hands out ranges until the job has none left, returns once this thread has nothing more to do
+static void runJobRanges(JobSystem& system, Job& job) {
+    while (true) {
+        int begin = job.next.fetch_add(job.grain);
+        if (begin >= job.count) {
+            return;
+        }
+        int end = std::min(begin + job.grain, job.count);
+        job.run(job.context, begin, end);
+
+        if (job.finished.fetch_add(end - begin) + (end - begin) == job.count) {
+            std::lock_guard<std::mutex> lock(system.mutex);
+            system.jobDone.notify_all();
+        }
+    }
+}
+
+static void workerLoop(JobSystem& system) {
+    while (true) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(system.mutex);
+            system.workAvailable.wait(lock, [&] { return system.stopping || system.queueSize > 0; });
+            if (system.stopping) {
+                return;
+            }
+            job = system.queue[system.queueStart];
+            job->users++;
+        }
+
+        runJobRanges(system, *job);
+
+        std::lock_guard<std::mutex> lock(system.mutex);
+        // every range is handed out, later workers should move on to the next job
+        system.removeFromQueue(job);
+        job->users--;
+        system.jobDone.notify_all();
+    }
+}
+
+JobSystem::JobSystem() {
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 0; i < threads - 1; ++i) {
+        workers.emplace_back(workerLoop, std::ref(*this));
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// caller holds the mutex
+void JobSystem::removeFromQueue(Job* job) {
+    for (int i = 0; i < queueSize; ++i) {
+        if (queue[(queueStart + i) % maxQueuedJobs] != job) {
+            continue;
+        }
+        for (int j = i; j > 0; --j) {
+            queue[(queueStart + j) % maxQueuedJobs] = queue[(queueStart + j - 1) % maxQueuedJobs];
+        }
+        queueStart = (queueStart + 1) % maxQueuedJobs;
+        queueSize--;
+        return;
+    }
+}
+
+int jobWorkerCount() {
+    return static_cast<int>(jobSystem().workers.size());
+}
+
+bool submitJob(Job& job) {
+    JobSystem& system = jobSystem();
+    if (job.count <= 0 || system.workers.empty()) {
+        return false; // waitForJob runs it on the calling thread
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(system.mutex);
+        if (system.queueSize == maxQueuedJobs) {
+            std::cerr << "Error::Job queue full, the job runs on the calling thread when it waits for it\n";
+            return false;
+        }
+        system.queue[(system.queueStart + system.queueSize) % maxQueuedJobs] = &job;
+        system.queueSize++;
+    }
+    system.workAvailable.notify_all();
+    return true;
+}
+
+bool jobFinished(const Job& job) {
+    return job.finished.load() >= job.count;
+}
+
+void waitForJob(Job& job) {
+    JobSystem& system = jobSystem();
+    runJobRanges(system, job);
+
+    std::unique_lock<std::mutex> lock(system.mutex);
+    system.removeFromQueue(&job);
+    system.jobDone.wait(lock, [&] { return job.finished.load() >= job.count && job.users.load() == 0; });
+}
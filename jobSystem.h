@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+// a batch of count work items handed to the worker threads in ranges of grain items.
+// the Job is owned by the caller and must stay alive until waitForJob returns,
+// which keeps submitting free of heap allocations
+struct Job {
+    void (*run)(void* context, int begin, int end) = nullptr;
+    void* context = nullptr;
+    int count = 0;
+    int grain = 1;
+
+    std::atomic<int> next{0};     // first item not handed out yet
+    std::atomic<int> finished{0}; // items completed
+    std::atomic<int> users{0};    // workers currently holding a pointer to the job
+};
+
+// worker threads are started on first use, one per core minus the calling thread
+int jobWorkerCount();
+// false when the job was not queued (no workers, or the queue is full), waitForJob then runs it
+bool submitJob(Job& job);
+bool jobFinished(const Job& job);
+// runs remaining ranges of the job on the calling thread, then blocks until every range is done
+void waitForJob(Job& job);
+
+// calls function(begin, end) over [0, count) split across the workers and the calling thread
+template <class Function>
+void parallelFor(int count, int grain, Function&& function) {
+    using FunctionType = std::remove_reference_t<Function>;
+
+    Job job;
+    job.run = [](void* context, int begin, int end) {
+        (*static_cast<FunctionType*>(context))(begin, end);
+    };
+    job.context = const_cast<void*>(static_cast<const void*>(&function));
+    job.count = count;
+    job.grain = grain > 0 ? grain : 1;
+
+    submitJob(job);
+    waitForJob(job);
+}
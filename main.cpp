@@ -6,44 +6,83 @@
 #include <glm/glm.hpp>  // GLM is an optimized math library with syntax similar to OpenGL Shading Language
 #include <glm/gtc/matrix_transform.hpp> // include this to create transformation matrices
 #include <glm/common.hpp>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <chrono>
 #include <cmath>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include "terrain.h"
+#include "terrainChunks.h"
+#include "terrainGrid.h"
+#include "geomipTerrain.h"
+#include "cdlodTerrain.h"
+#include "clipmapTerrain.h"
+#include "rtinTerrain.h"
+#include "meshletTerrain.h"
+#include "instancedTerrain.h"
+#include "splineTerrain.h"
+#include "tessellatedTerrain.h"
+#include "stripDraws.h"
+#include "renderQueue.h"
+#include "heightTexture.h"
+#include "heightCompute.h"
+#include "compressedTexture.h"
+#include "textureLoader.h"
+#include "debugLines.h"
+#include "camera.h"
+#include "cameraBuffer.h"
+#include "renderStats.h"
+#include "jobSystem.h"
+#include "glState.h"
+#include "shaderProgram.h"
 
 std::string loadShader(const char*);
-int compileAndLinkShaders(const char* , const char*);
-void setProjectionMatrix(int, glm::mat4);
-void setWorldMatrix(int, glm::mat4);
-void setViewMatrix(int, glm::mat4);
 int createTexturedTerrainVAO();
-float catmullRom(float p0, float p1, float p2, float p3, float t);
-void generateControlPoints();
-void generateHeightMap();
-float getHeightAt(float worldX, float worldZ);
-void drawTerrain(GLuint shaderProgram, int terrainVAO, GLuint texture);
-GLuint loadTexture(const char* path);
+void drawTerrain(GLuint shaderProgram, int terrainVAO, GLuint texture, const StripDraws& strips, StripSubmission submission);
+bool keyPressed(GLFWwindow* window, int key);
+void benchmarkCameraPath(float t, glm::vec3& position, glm::vec3& lookAt);
+
+// terrain renderers, M cycles through them
+enum TerrainMode {
+    TerrainFullRes,
+    TerrainChunked,
+    TerrainGeomip,
+    TerrainCdlod,
+    TerrainClipmap,
+    TerrainRtin,
+    TerrainMeshlet,
+    TerrainInstanced,
+    TerrainSpline,
+    TerrainTessellated,
+    TerrainModeCount
+};
+const char* terrainModeNames[TerrainModeCount] = { "full res", "chunked", "geomip", "cdlod", "clipmap", "rtin", "meshlets", "instanced", "spline", "tessellated" };
 
-// Constants for control point and terrain resolution
-const int controlSize = 20;
-const int fineSize = 200;
+// --benchmark flies this many frames along a fixed path per terrain mode
+const int benchmarkFrames = 600;
 
 // 2D arrays for control points and resulting height map
 float controlPoints[controlSize][controlSize];
 float heightMap[fineSize][fineSize];
 
-// creating VAO for terrain
-struct Vertex {
-    glm::vec3 position;
-    glm::vec2 texCoord;
-};
-
 // Main entry point
-int main() {
-    // generate terrain
-    srand(static_cast<unsigned int>(time(0)));
+int main(int argc, char** argv) {
+    bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
+    // --validate-compute generates the heights on the GPU, compares them with the CPU and exits
+    bool validateCompute = argc > 1 && std::string(argv[1]) == "--validate-compute";
+
+    // --bake-textures writes block compressed .dds files next to the PNGs and exits
+    if (argc > 1 && std::string(argv[1]) == "--bake-textures") {
+        bakeTextures();
+        return 0;
+    }
+
+    // generate terrain, the benchmark always uses the same dunes
+    srand(benchmark ? 1u : static_cast<unsigned int>(time(0)));
     generateControlPoints();
     generateHeightMap();
 
@@ -69,6 +108,11 @@ int main() {
     glfwMakeContextCurrent(window);
     glewExperimental = GL_TRUE;
 
+    // don't let vsync hide frame time differences while benchmarking
+    if (benchmark) {
+        glfwSwapInterval(0);
+    }
+
     // initialize GLEW
     if (glewInit() != GLEW_OK) {
         std::cerr << "Failed to initialize GLEW\n";
@@ -76,9 +120,11 @@ int main() {
     }
 
     // load textures
-    GLuint sandTexture = loadTexture("sand/Ground080_1K-PNG_Color.png");
+    // decoded in the background, a flat sand colour stands in until its levels are resident
+    TextureLoader textureLoader = createTextureLoader();
+    GLuint sandTexture = loadTextureAsync(textureLoader, "sand/Ground080_1K-PNG_Color.png", glm::vec3(0.84f, 0.71f, 0.52f));
 
-    glEnable(GL_DEPTH_TEST);
+    setCapability(GL_DEPTH_TEST, true);
     glClearColor(0.95f, 0.87f, 0.72f, 1.0f); // background sky tint
 
     // compile and link shaders
@@ -86,13 +132,50 @@ int main() {
     const std::string fragmentShaderSource = loadShader("shaders/fragmentShader.glsl");
     const std::string textureVertexShaderSource = loadShader("shaders/texturedVertexShader.glsl");
     const std::string textureFragmentShaderSource = loadShader("shaders/texturedFragmentShader.glsl");
+    const std::string cdlodVertexShaderSource = loadShader("shaders/cdlodVertexShader.glsl");
+    const std::string clipmapVertexShaderSource = loadShader("shaders/clipmapVertexShader.glsl");
+    const std::string instancedVertexShaderSource = loadShader("shaders/instancedVertexShader.glsl");
+    const std::string splineVertexShaderSource = loadShader("shaders/splineVertexShader.glsl");
+    const std::string tessVertexShaderSource = loadShader("shaders/tessVertexShader.glsl");
+    const std::string tessControlShaderSource = loadShader("shaders/tessControlShader.glsl");
+    const std::string tessEvaluationShaderSource = loadShader("shaders/tessEvaluationShader.glsl");
+    const std::string heightComputeShaderSource = loadShader("shaders/heightComputeShader.glsl");
     const char* vShaderCode = vertexShaderSource.c_str();
     const char* fShaderCode = fragmentShaderSource.c_str();
     const char* tvShaderCode = textureVertexShaderSource.c_str();
     const char* tfShaderCode = textureFragmentShaderSource.c_str();
-
-    int colorShaderProgram = compileAndLinkShaders(vShaderCode, fShaderCode);
-    int textureShaderProgram = compileAndLinkShaders(tvShaderCode, tfShaderCode);
+    const char* cdlodShaderCode = cdlodVertexShaderSource.c_str();
+    const char* clipmapShaderCode = clipmapVertexShaderSource.c_str();
+    const char* instancedShaderCode = instancedVertexShaderSource.c_str();
+    const char* splineShaderCode = splineVertexShaderSource.c_str();
+
+    ShaderProgram colorShader = createShaderProgram(vShaderCode, fShaderCode);
+    ShaderProgram textureShader = createShaderProgram(tvShaderCode, tfShaderCode);
+    ShaderProgram cdlodShader = createShaderProgram(cdlodShaderCode, tfShaderCode);
+    ShaderProgram clipmapShader = createShaderProgram(clipmapShaderCode, tfShaderCode);
+    ShaderProgram instancedShader = createShaderProgram(instancedShaderCode, tfShaderCode);
+    ShaderProgram splineShader = createShaderProgram(splineShaderCode, tfShaderCode);
+    GLuint textureShaderProgram = textureShader.program;
+
+    // the texture shader's transform changes every frame, the sampler never does
+    Uniform<glm::mat4> textureWorldViewProjection = findUniform<glm::mat4>(textureShader, "worldViewProjection");
+    useProgram(textureShaderProgram);
+    setUniform(findUniform<int>(textureShader, "textureSampler"), 0);
+
+    // view and projection for the shaders that place vertices themselves, written once per frame
+    CameraBuffer cameraBuffer = createCameraBuffer();
+    attachCameraBlock(cdlodShader);
+    attachCameraBlock(clipmapShader);
+    attachCameraBlock(instancedShader);
+    attachCameraBlock(splineShader);
+
+    // the tessellation stages don't compile below GL 4.0, that mode is left empty there
+    ShaderProgram tessShader = {};
+    if (tessellationSupported()) {
+        tessShader = createTessellationProgram(tessVertexShaderSource.c_str(), tessControlShaderSource.c_str(),
+                                               tessEvaluationShaderSource.c_str(), tfShaderCode);
+        attachCameraBlock(tessShader);
+    }
 
     // lookAt() parameters for view transform
     glm::vec3 cameraPosition(0.6f,15.0f,0.0f);
@@ -110,42 +193,166 @@ int main() {
 
     // set up default view matrix
     glm::mat4 viewMatrix = glm::lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
-    setViewMatrix(colorShaderProgram, viewMatrix );
-    setViewMatrix(textureShaderProgram, viewMatrix );
 
     // set up default projection matrix
     glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 800.0f/600.0f, 0.01f, 1000.0f);
-    setProjectionMatrix(colorShaderProgram, projectionMatrix);
-    setProjectionMatrix(textureShaderProgram, projectionMatrix);
+    // the terrain meshes are built in world space
+    glm::mat4 terrainWorldMatrix(1.0f);
 
     // create terrain VAO
     int terrainVAO = createTexturedTerrainVAO();
-    glBindVertexArray(terrainVAO);
+    bindVertexArray(terrainVAO);
+    // N cycles how the full resolution strips are submitted
+    StripDraws terrainStrips = createStripDraws(terrainVAO, fineSize - 1, fineSize * 2);
+    StripSubmission stripSubmission = StripDrawLoop;
+
+    // split terrain into chunks for frustum culling and level of detail
+    TerrainChunkGrid terrainChunks = createTerrainChunks();
+    // H toggles horizon occlusion of the chunks
+    HorizonCuller horizonCuller = createHorizonCuller(buildHeightPyramid(), horizonOccluderLevel);
+    terrainChunks.horizon = &horizonCuller;
+    // O toggles the software depth buffer, rasterized for the next frame as soon as the camera has moved
+    DepthOcclusion depthOcclusion = createDepthOcclusion();
+    GLuint terrainGridVBO = createTerrainGridVBO();
+    GeomipTerrain geomipTerrain = createGeomipTerrain(terrainGridVBO, terrainChunks);
+    // with compute shaders only the control points go to the GPU, the heights are generated there.
+    // kept for the whole run so new control points can be turned into heights again
+    HeightCompute heightCompute = {};
+    if (heightComputeSupported()) {
+        heightCompute = createHeightCompute(heightComputeShaderSource.c_str());
+    }
+    GLuint heightTexture = createHeightTexture(!heightCompute.linked);
+    if (heightCompute.linked) {
+        generateHeightsOnGpu(heightCompute, heightTexture);
+    }
+    if (validateCompute) {
+        if (!heightCompute.linked) {
+            if (heightComputeSupported()) {
+                std::cerr << "Error::Height compute shader did not link, nothing to validate\n";
+            } else {
+                std::cerr << "Error::Compute shaders need OpenGL 4.3, this context is " << glGetString(GL_VERSION) << "\n";
+            }
+            glfwTerminate();
+            return 1;
+        }
+        float difference = compareHeightsWithCpu(heightTexture);
+        bool passed = difference <= heightComputeTolerance;
+        std::cout << "compute heights on " << glGetString(GL_RENDERER) << ": max difference to the CPU "
+                  << difference << ", tolerance " << heightComputeTolerance << (passed ? ", passed" : ", FAILED") << std::endl;
+        glfwTerminate();
+        return passed ? 0 : 1;
+    }
+    CdlodTerrain cdlodTerrain = createCdlodTerrain(cdlodShader, heightTexture);
+    ClipmapTerrain clipmapTerrain = createClipmapTerrain(clipmapShader, getHeightAt);
+    RtinTerrain rtinTerrain = createRtinTerrain(terrainGridVBO, 0.05f);
+    MeshletTerrain meshletTerrain = createMeshletTerrain(terrainGridVBO);
+    InstancedTerrain instancedTerrain = createInstancedTerrain(instancedShader, terrainChunks);
+    SplineTerrain splineTerrain = createSplineTerrain(splineShader);
+    TessellatedTerrain tessellatedTerrain = createTessellatedTerrain(tessellationSupported() ? &tessShader : nullptr, heightTexture);
+    TerrainMode terrainMode = benchmark ? TerrainFullRes : TerrainChunked;
+
+    // the chunked renderers queue their draws, which are sorted by state and depth before issuing
+    RenderQueue renderQueue;
+
+    // B shows the chunk bounds, green when inside the frustum and red when culled
+    DebugLines debugLines = createDebugLines(colorShader);
+    bool showChunkBounds = false;
+
+    FrameCamera frameCamera;
+    frameCamera.fieldOfView = glm::radians(60.0f);
+    frameCamera.viewportHeight = 600;
+
+    // per mode totals for --benchmark
+    int benchmarkFrame = 0;
+    double benchmarkTime = 0.0;
+    long long benchmarkTriangles = 0;
+    long long benchmarkConeCulled = 0;
+    long long benchmarkDrawCalls = 0;
 
     // Game loop
+    // the benchmark measures the finished texture, not the upload
+    while (benchmark && !textureLoaderIdle(textureLoader)) {
+        updateTextureLoader(textureLoader);
+    }
+
     while (!glfwWindowShouldClose(window)) {
 
         float dt = glfwGetTime() - lastFrameTime;
         lastFrameTime += dt;
+        resetRenderStats();
+        updateTextureLoader(textureLoader);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(textureShaderProgram);
-        int samplerLocation = glGetUniformLocation(textureShaderProgram, "textureSampler");
-        if (samplerLocation == -1) {
-            std::cerr << "Uniform 'textureSampler' not found in shader!\n";
-        }
-        glUniform1i(samplerLocation, 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sandTexture);
+        frameCamera.viewMatrix = viewMatrix;
+        frameCamera.projectionMatrix = projectionMatrix;
+        frameCamera.viewProjection = projectionMatrix * viewMatrix;
+        frameCamera.position = cameraPosition;
+        updateCameraBuffer(cameraBuffer, frameCamera);
 
-
-        setWorldMatrix(textureShaderProgram, glm::mat4(1.0f));
+        useProgram(textureShaderProgram);
+        activeTexture(0);
+        bindTexture(GL_TEXTURE_2D, sandTexture);
+        setUniform(textureWorldViewProjection, frameCamera.viewProjection * terrainWorldMatrix);
 
         // generate and bind terrain VAO & VBO
-        drawTerrain(textureShaderProgram, terrainVAO, sandTexture);
+        terrainChunks.culled = false;
+        switch (terrainMode) {
+            case TerrainFullRes:
+                drawTerrain(textureShaderProgram, terrainVAO, sandTexture, terrainStrips, stripSubmission);
+                break;
+            case TerrainChunked:
+                submitTerrainChunks(renderQueue, textureShaderProgram, terrainVAO, sandTexture, terrainChunks, frameCamera);
+                break;
+            case TerrainGeomip:
+                submitGeomipTerrain(renderQueue, textureShaderProgram, sandTexture, geomipTerrain, terrainChunks, frameCamera);
+                break;
+            case TerrainCdlod:
+                drawCdlodTerrain(cdlodTerrain, sandTexture, frameCamera);
+                break;
+            case TerrainClipmap:
+                drawClipmapTerrain(clipmapTerrain, sandTexture, frameCamera);
+                break;
+            case TerrainRtin:
+                submitRtinTerrain(renderQueue, textureShaderProgram, sandTexture, rtinTerrain, terrainChunks, frameCamera);
+                break;
+            case TerrainMeshlet:
+                drawMeshletTerrain(textureShaderProgram, sandTexture, meshletTerrain, frameCamera);
+                break;
+            case TerrainInstanced:
+                drawInstancedTerrain(instancedTerrain, sandTexture, terrainChunks, frameCamera);
+                break;
+            case TerrainSpline:
+                drawSplineTerrain(splineTerrain, sandTexture);
+                break;
+            case TerrainTessellated:
+                drawTessellatedTerrain(tessellatedTerrain, sandTexture, frameCamera);
+                break;
+            default:
+                break;
+        }
+        executeRenderQueue(renderQueue);
 
-        glfwSwapBuffers(window);
+        if (showChunkBounds) {
+            // reuse this frame's culling, modes without chunks test them here without counting it
+            if (!terrainChunks.culled) {
+                testTerrainChunks(terrainChunks, frameCamera);
+            }
+            for (size_t c = 0; c < terrainChunks.chunks.size(); ++c) {
+                glm::vec3 color = terrainChunks.visible[c] ? glm::vec3(0.0f, 0.8f, 0.0f) : glm::vec3(0.8f, 0.0f, 0.0f);
+                addDebugBox(debugLines, terrainChunks.chunks[c].boundsMin, terrainChunks.chunks[c].boundsMax, color);
+            }
+            drawDebugLines(debugLines, frameCamera);
+        }
+        endCameraFrame(cameraBuffer);
+
+        if (benchmark) {
+            // include the GPU work in the measured frame time
+            glFinish();
+        }
+
+        // events are handled before the swap, so the next camera is known while the swap
+        // waits for vsync and the occluders for it are rasterized in the meantime
         glfwPollEvents();
 
         // -------------------- input handler
@@ -157,6 +364,27 @@ int main() {
 
         // space bar for starting
 
+        // M for switching between terrain renderers
+        if (!benchmark && keyPressed(window, GLFW_KEY_M)) {
+            terrainMode = static_cast<TerrainMode>((terrainMode + 1) % TerrainModeCount);
+            std::cout << "terrain mode: " << terrainModeNames[terrainMode] << std::endl;
+        }
+        if (!benchmark && keyPressed(window, GLFW_KEY_N)) {
+            stripSubmission = static_cast<StripSubmission>((stripSubmission + 1) % StripSubmissionCount);
+            std::cout << "strip submission: " << stripSubmissionNames[stripSubmission] << std::endl;
+        }
+        if (!benchmark && keyPressed(window, GLFW_KEY_B)) {
+            showChunkBounds = !showChunkBounds;
+        }
+        if (!benchmark && keyPressed(window, GLFW_KEY_H)) {
+            terrainChunks.horizon = terrainChunks.horizon ? nullptr : &horizonCuller;
+            std::cout << "horizon occlusion " << (terrainChunks.horizon ? "on" : "off") << std::endl;
+        }
+        if (!benchmark && keyPressed(window, GLFW_KEY_O)) {
+            terrainChunks.depthOcclusion = terrainChunks.depthOcclusion ? nullptr : &depthOcclusion;
+            std::cout << "depth buffer occlusion " << (terrainChunks.depthOcclusion ? "on" : "off") << std::endl;
+        }
+
         // SHIFT for fast speed
         bool fastCam = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
         float currentCameraSpeed = (fastCam) ? cameraFastSpeed : cameraSpeed;
@@ -195,13 +423,65 @@ int main() {
         }
         // cameraPosition += movementDirection * currentCameraSpeed * dt;
 
+        // the benchmark replaces mouse and keyboard with a fixed path, the first frame
+        // of every mode is skipped because it still holds the previous mode's timing
+        if (benchmark) {
+            if (benchmarkFrame > 0) {
+                benchmarkTime += dt;
+                benchmarkTriangles += renderStats.trianglesDrawn;
+                benchmarkConeCulled += renderStats.trianglesConeCulled;
+                benchmarkDrawCalls += renderStats.drawCalls;
+            }
+            if (++benchmarkFrame > benchmarkFrames) {
+                std::cout << "benchmark " << terrainModeNames[terrainMode];
+                if (terrainMode == TerrainFullRes) {
+                    std::cout << " (" << stripSubmissionNames[stripSubmission] << ")";
+                }
+                std::cout << ": " << benchmarkTime / benchmarkFrames * 1000.0 << " ms/frame, "
+                          << benchmarkTriangles / benchmarkFrames << " triangles/frame, "
+                          << benchmarkDrawCalls / benchmarkFrames << " draw calls/frame";
+                if (benchmarkConeCulled > 0) {
+                    // share of the triangles left after frustum culling that faced away
+                    std::cout << ", " << 100.0 * benchmarkConeCulled / (benchmarkConeCulled + benchmarkTriangles)
+                              << "% rejected by normal cones";
+                }
+                std::cout << std::endl;
+                benchmarkFrame = 0;
+                benchmarkTime = 0.0;
+                benchmarkTriangles = 0;
+                benchmarkConeCulled = 0;
+                benchmarkDrawCalls = 0;
+
+                // full res runs once per strip submission before moving on
+                if (terrainMode == TerrainFullRes && stripSubmission + 1 < StripSubmissionCount) {
+                    stripSubmission = static_cast<StripSubmission>(stripSubmission + 1);
+                } else {
+                    terrainMode = static_cast<TerrainMode>(terrainMode + 1);
+                }
+                if (terrainMode == TerrainModeCount) {
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+            benchmarkCameraPath(benchmarkFrame / (float)benchmarkFrames, cameraPosition, cameraLookAt);
+        }
+
         // get y from new x and z position, to stay on terrain
         cameraPosition.y = getHeightAt(cameraPosition.x, cameraPosition.z) +2.0f;
 
         viewMatrix = glm::lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp );
-        setViewMatrix(textureShaderProgram, viewMatrix );
+
+        // the worker threads rasterize the occluders during the swap and the next frame's start
+        if (terrainChunks.depthOcclusion) {
+            rasterizeOccludersAsync(depthOcclusion, projectionMatrix * viewMatrix);
+        }
+
+        glfwSwapBuffers(window);
+        reportRenderStats(dt);
     }
 
+    waitForOccluders(depthOcclusion);
+    destroyTextureLoader(textureLoader);
+    destroyHeightCompute(heightCompute);
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
@@ -229,16 +509,18 @@ void generateControlPoints() {
     }
 }
 
-// create fine height map from control points using Catmull-Rom splines
+// create fine height map from control points using Catmull-Rom splines.
+// the last row and column use t = 1 of the previous span, so index + 3 stays inside
+// controlPoints. shaders/heightComputeShader.glsl has to match this exactly
 void generateHeightMap() {
     for (int z = 0; z < fineSize; ++z) {
         float zRatio = (float)z / (fineSize - 1) * (controlSize - 3);
-        int zIndex = (int)zRatio;
+        int zIndex = std::min((int)zRatio, controlSize - 4);
         float tz = zRatio - zIndex;
 
         for (int x = 0; x < fineSize; ++x) {
             float xRatio = (float)x / (fineSize - 1) * (controlSize - 3);
-            int xIndex = (int)xRatio;
+            int xIndex = std::min((int)xRatio, controlSize - 4);
             float tx = xRatio - xIndex;
 
             float col[4];
@@ -286,54 +568,30 @@ float getHeightAt(float worldX, float worldZ) {
 }
 
 // renders the heightMap as a textured mesh using triangle strips
-void drawTerrain(GLuint shaderProgram, int terrainVAO, GLuint texture) {
-    glUseProgram(shaderProgram);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glBindVertexArray(terrainVAO);
-
-    for (int z = 0; z < fineSize - 1; ++z) {
-        int verticesPerStrip = fineSize * 2;
-        glDrawArrays(GL_TRIANGLE_STRIP, z * verticesPerStrip, verticesPerStrip);
-    }
+void drawTerrain(GLuint shaderProgram, int terrainVAO, GLuint texture, const StripDraws& strips, StripSubmission submission) {
+    useProgram(shaderProgram);
+    bindTexture(GL_TEXTURE_2D, texture);
+    bindVertexArray(terrainVAO);
 
-    glBindVertexArray(0);
+    // one strip per height map row
+    drawStrips(strips, submission);
 }
 
-GLuint loadTexture(const char* path) {
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (!data) {
-        std::cerr << "Error::Texture could not load texture file: " << path << std::endl;
-        return 0;
-    }
-
-    GLuint textureId = 0;
-    glGenTextures(1, &textureId);
-    if (textureId == 0) {
-        std::cerr << "Error::Failed to generate texture ID\n";
-        stbi_image_free(data);
-        return 0;
-    }
-
-    glBindTexture(GL_TEXTURE_2D, textureId);
-
-    GLenum format = GL_RGB;
-    if (nrChannels == 1) format = GL_RED;
-    else if (nrChannels == 3) format = GL_RGB;
-    else if (nrChannels == 4) format = GL_RGBA;
-
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-
-    // Set texture parameters (wrap & filter)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
+// one loop around the middle of the map for t in [0, 1], looking along the path
+void benchmarkCameraPath(float t, glm::vec3& position, glm::vec3& lookAt) {
+    float angle = t * 2.0f * glm::radians(180.0f);
+    float radius = fineSize * 0.3f;
+    position = glm::vec3(radius * cosf(angle), position.y, radius * sinf(angle));
+    lookAt = glm::normalize(glm::vec3(-sinf(angle), -0.15f, cosf(angle)));
+}
 
-    return textureId;
+// true only on the frame a key goes down, so toggles don't flip every frame while held
+bool keyPressed(GLFWwindow* window, int key) {
+    static bool wasDown[GLFW_KEY_LAST + 1] = {};
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool pressed = down && !wasDown[key];
+    wasDown[key] = down;
+    return pressed;
 }
 
 std::string loadShader(const char* filepath) {
@@ -348,105 +606,54 @@ std::string loadShader(const char* filepath) {
     return buffer.str();
 }
 
-int compileAndLinkShaders(const char* vertexShaderSource, const char* fragmentShaderSource) {
-
-    // create and compile vertex shader
-    int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // check for vertex shader compilation success
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Error compiling vertex shader\n" << infoLog << std::endl;
-    }
-
-    // create and compile fragment shader
-    int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // check for fragment shader compilation success
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Error compiling fragment shader\n" << infoLog << std::endl;
-    }
-
-    // link shaders
-    int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Error linking shader program\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-void setProjectionMatrix(int shaderProgram, glm::mat4 projectionMatrix){
-    glUseProgram(shaderProgram);
-    GLuint projectionMatrixLocation = glGetUniformLocation(shaderProgram, "projectionMatrix");
-    glUniformMatrix4fv(projectionMatrixLocation, 1, GL_FALSE, &projectionMatrix[0][0]);
-}
-
-void setViewMatrix(int shaderProgram, glm::mat4 viewMatrix){
-    glUseProgram(shaderProgram);
-    GLuint viewMatrixLocation = glGetUniformLocation(shaderProgram, "viewMatrix");
-    glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, &viewMatrix[0][0]);
-}
-
-void setWorldMatrix(int shaderProgram, glm::mat4 worldMatrix){
-    glUseProgram(shaderProgram);
-    GLuint worldMatrixLocation = glGetUniformLocation(shaderProgram, "worldMatrix");
-    glUniformMatrix4fv(worldMatrixLocation, 1, GL_FALSE, &worldMatrix[0][0]);
-}
-
 int createTexturedTerrainVAO() {
     GLuint terrainVAO, terrainVBO;
-    std::vector<Vertex> terrainVertices;
-
-    // create vertex array for terrain, centered around (0,0,0)
-    float offset = fineSize / 2.0f;
-
-    for (int z = 0; z < fineSize - 1; ++z) {
-        for (int x = 0; x < fineSize; ++x) {
-            float u = x / (float)(fineSize - 1) * 10.0f;
-            float v1 = z / (float)(fineSize - 1) * 10.0f;
-            float v2 = (z + 1) / (float)(fineSize - 1) * 10.0f;
-
-            // Flip z and offset both x and z to center terrain around origin
-            terrainVertices.push_back({
-                glm::vec3(x - offset, heightMap[z][x], -(z - offset)),
-                glm::vec2(u, v1)
-            });
-
-            terrainVertices.push_back({
-                glm::vec3(x - offset, heightMap[z + 1][x], -(z + 1 - offset)),
-                glm::vec2(u, v2)
-            });
-        }
-    }
 
     // create VAO
     glGenVertexArrays(1, &terrainVAO);
-    glBindVertexArray(terrainVAO);
+    bindVertexArray(terrainVAO);
 
-    // create and bind VBO
+    // create and bind VBO, sized up front so the vertices can be written straight into it
+    const int verticesPerStrip = fineSize * 2;
+    const GLsizeiptr bufferSize = (GLsizeiptr)(fineSize - 1) * verticesPerStrip * sizeof(Vertex);
     glGenBuffers(1, &terrainVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, terrainVBO);
-    glBufferData(GL_ARRAY_BUFFER, terrainVertices.size() * sizeof(Vertex), terrainVertices.data(), GL_STATIC_DRAW);
+    bindBuffer(GL_ARRAY_BUFFER, terrainVBO);
+    glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+    Vertex* terrainVertices = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize,
+                                                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!terrainVertices) {
+        std::cerr << "Error::Failed to map terrain vertex buffer\n";
+    } else {
+        // create vertex array for terrain, centered around (0,0,0), one strip per row
+        // filled by the worker threads in disjoint row ranges
+        float offset = fineSize / 2.0f;
+
+        parallelFor(fineSize - 1, 8, [&](int begin, int end) {
+            for (int z = begin; z < end; ++z) {
+                Vertex* strip = terrainVertices + z * verticesPerStrip;
+                for (int x = 0; x < fineSize; ++x) {
+                    float u = x / (float)(fineSize - 1) * 10.0f;
+                    float v1 = z / (float)(fineSize - 1) * 10.0f;
+                    float v2 = (z + 1) / (float)(fineSize - 1) * 10.0f;
+
+                    // Flip z and offset both x and z to center terrain around origin
+                    strip[x * 2] = {
+                        glm::vec3(x - offset, heightMap[z][x], -(z - offset)),
+                        glm::vec2(u, v1)
+                    };
+
+                    strip[x * 2 + 1] = {
+                        glm::vec3(x - offset, heightMap[z + 1][x], -(z + 1 - offset)),
+                        glm::vec2(u, v2)
+                    };
+                }
+            }
+        });
+
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+            std::cerr << "Error::Terrain vertex buffer was lost while mapped\n";
+        }
+    }
 
     // vertex attributes
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -455,7 +662,7 @@ int createTexturedTerrainVAO() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
     glEnableVertexAttribArray(1);
 
-    glBindVertexArray(0);
+    bindVertexArray(0);
 
     return terrainVAO;
 }
@@ -0,0 +1,200 @@
+#include "meshletTerrain.h"
+#include "frustum.h"
+#include "glState.h"
+#include "renderStats.h"
+#include "simd.h"
+#include "terrainGrid.h"
+#include "vertexCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+static glm::vec3 gridPosition(int x, int z) {
+    float offset = fineSize / 2.0f;
+    return glm::vec3(x - offset, heightMap[z][x], -(z - offset));
+}
+
+static void addBounds(MeshletBounds& bounds, glm::vec3 center, float radius, glm::vec3 axis, float cutoffSquared) {
+    int index = bounds.count++;
+    int padded = (bounds.count + 3) & ~3;
+
+    // padding lanes are never read back
+    for (std::vector<float>* component : { &bounds.centerX, &bounds.centerY, &bounds.centerZ, &bounds.radius,
+                                           &bounds.axisX, &bounds.axisY, &bounds.axisZ, &bounds.cutoffSquared }) {
+        component->resize(padded, 0.0f);
+    }
+
+    bounds.centerX[index] = center.x;
+    bounds.centerY[index] = center.y;
+    bounds.centerZ[index] = center.z;
+    bounds.radius[index] = radius;
+    bounds.axisX[index] = axis.x;
+    bounds.axisY[index] = axis.y;
+    bounds.axisZ[index] = axis.z;
+    bounds.cutoffSquared[index] = cutoffSquared;
+}
+
+// triangles of the quads [x0, x1) x [z0, z1), same diagonal as the geomip levels, plus
+// the meshlet's bounds. normals point up, a height field has no other front side
+static void buildMeshlet(int x0, int z0, int x1, int z1, std::vector<unsigned int>& indices, MeshletBounds& bounds) {
+    int first = static_cast<int>(indices.size());
+    std::vector<glm::vec3> normals;
+
+    auto triangle = [&](int ax, int az, int bx, int bz, int cx, int cz) {
+        glm::vec3 a = gridPosition(ax, az), b = gridPosition(bx, bz), c = gridPosition(cx, cz);
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+        normals.push_back(normal.y < 0.0f ? -normal : normal);
+        indices.push_back(gridIndex(ax, az));
+        indices.push_back(gridIndex(bx, bz));
+        indices.push_back(gridIndex(cx, cz));
+    };
+
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    for (int z = z0; z < z1; ++z) {
+        for (int x = x0; x < x1; ++x) {
+            triangle(x, z, x, z + 1, x + 1, z);
+            triangle(x + 1, z, x, z + 1, x + 1, z + 1);
+        }
+    }
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            boundsMin = glm::min(boundsMin, gridPosition(x, z));
+            boundsMax = glm::max(boundsMax, gridPosition(x, z));
+        }
+    }
+
+    // cone axis is the average normal, its half angle the widest normal from it
+    glm::vec3 axis(0.0f);
+    for (const glm::vec3& normal : normals) {
+        axis += normal;
+    }
+    axis = glm::normalize(axis);
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+    // cones wider than ~85 degrees would almost never cull, mark them as never culled
+    float cutoffSquared = minDot <= 0.1f ? 2.0f : 1.0f - minDot * minDot;
+
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    addBounds(bounds, center, glm::length(boundsMax - center), axis, cutoffSquared);
+
+    int count = static_cast<int>(indices.size()) - first;
+    optimizeVertexCache(&indices[first], count);
+}
+
+MeshletTerrain createMeshletTerrain(GLuint gridVBO) {
+    MeshletTerrain terrain;
+
+    // meshlets of a chunk are stored together so a visible chunk merges into few draws
+    std::vector<unsigned int> indices;
+    for (int cz = 0; cz < chunksPerSide; ++cz) {
+        for (int cx = 0; cx < chunksPerSide; ++cx) {
+            for (int mz = cz * chunkQuads; mz < (cz + 1) * chunkQuads && mz < fineSize - 1; mz += meshletQuads) {
+                for (int mx = cx * chunkQuads; mx < (cx + 1) * chunkQuads && mx < fineSize - 1; mx += meshletQuads) {
+                    int offset = static_cast<int>(indices.size());
+                    buildMeshlet(mx, mz, std::min(mx + meshletQuads, fineSize - 1), std::min(mz + meshletQuads, fineSize - 1),
+                                 indices, terrain.bounds);
+                    terrain.indexOffset.push_back(offset);
+                    terrain.indexCount.push_back(static_cast<int>(indices.size()) - offset);
+                }
+            }
+        }
+    }
+    terrain.triangleCount = indices.size() / 3;
+    terrain.visible.resize(terrain.bounds.count, 1);
+    terrain.drawCounts.reserve(terrain.bounds.count);
+    terrain.drawOffsets.reserve(terrain.bounds.count);
+
+    glGenBuffers(1, &terrain.ibo);
+    terrain.vao = createTerrainGridVAO(gridVBO, terrain.ibo);
+    bindVertexArray(terrain.vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    bindVertexArray(0);
+
+    std::cout << "meshlets: " << terrain.bounds.count << " of up to " << 2 * meshletQuads * meshletQuads
+              << " triangles" << std::endl;
+    return terrain;
+}
+
+// four meshlets per iteration. frustum: sphere entirely behind a plane. cone: with
+// v = center - camera, every triangle faces away when dot(v, axis) >= cutoff * |v| + radius,
+// tested as d = dot(v, axis) - radius >= 0 and d^2 >= cutoff^2 * |v|^2 to avoid the sqrt
+void cullMeshlets(MeshletTerrain& terrain, const FrameCamera& camera) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const MeshletBounds& bounds = terrain.bounds;
+    Frustum frustum = extractFrustumPlanes(camera.viewProjection);
+    const f32x4 zero = splat4(0.0f);
+    const f32x4 cameraX = splat4(camera.position.x);
+    const f32x4 cameraY = splat4(camera.position.y);
+    const f32x4 cameraZ = splat4(camera.position.z);
+
+    for (int i = 0; i < bounds.count; i += 4) {
+        f32x4 cx = load4(&bounds.centerX[i]);
+        f32x4 cy = load4(&bounds.centerY[i]);
+        f32x4 cz = load4(&bounds.centerZ[i]);
+        f32x4 radius = load4(&bounds.radius[i]);
+
+        int outside = 0;
+        for (const glm::vec4& plane : frustum.planes) {
+            f32x4 distance = cx * splat4(plane.x) + cy * splat4(plane.y) + cz * splat4(plane.z) + splat4(plane.w);
+            outside |= lessMask4(distance + radius, zero);
+        }
+
+        f32x4 vx = cx - cameraX;
+        f32x4 vy = cy - cameraY;
+        f32x4 vz = cz - cameraZ;
+        f32x4 d = vx * load4(&bounds.axisX[i]) + vy * load4(&bounds.axisY[i]) + vz * load4(&bounds.axisZ[i]) - radius;
+        f32x4 lengthSquared = vx * vx + vy * vy + vz * vz;
+        int facing = lessMask4(d, zero) | lessMask4(d * d, load4(&bounds.cutoffSquared[i]) * lengthSquared);
+
+        for (int lane = 0; lane < 4 && i + lane < bounds.count; ++lane) {
+            int m = i + lane;
+            if (outside & (1 << lane)) {
+                terrain.visible[m] = 0;
+                renderStats.chunksCulled++;
+            } else if (!(facing & (1 << lane))) {
+                terrain.visible[m] = 0;
+                renderStats.trianglesConeCulled += terrain.indexCount[m] / 3;
+            } else {
+                terrain.visible[m] = 1;
+            }
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    renderStats.selectionMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void drawMeshletTerrain(GLuint shaderProgram, GLuint texture, MeshletTerrain& terrain, const FrameCamera& camera) {
+    cullMeshlets(terrain, camera);
+
+    // merge runs of visible meshlets, their indices follow each other in the buffer
+    terrain.drawCounts.clear();
+    terrain.drawOffsets.clear();
+    int m = 0;
+    while (m < terrain.bounds.count) {
+        if (!terrain.visible[m]) {
+            ++m;
+            continue;
+        }
+        int first = m;
+        int count = 0;
+        while (m < terrain.bounds.count && terrain.visible[m]) {
+            count += terrain.indexCount[m++];
+        }
+        terrain.drawCounts.push_back(count);
+        terrain.drawOffsets.push_back((const void*)(terrain.indexOffset[first] * sizeof(unsigned int)));
+        renderStats.chunksSubmitted += m - first;
+        renderStats.trianglesDrawn += count / 3;
+    }
+
+    useProgram(shaderProgram);
+    bindTexture(GL_TEXTURE_2D, texture);
+    bindVertexArray(terrain.vao);
+    glMultiDrawElements(GL_TRIANGLES, terrain.drawCounts.data(), GL_UNSIGNED_INT,
+                        terrain.drawOffsets.data(), (GLsizei)terrain.drawCounts.size());
+    renderStats.drawCalls++;
+}
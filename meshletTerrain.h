@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+
+// full resolution terrain split into small clusters of triangles (meshlets), each with
+// a bounding sphere and a cone around its triangle normals. a meshlet whose triangles
+// all face away from the camera, like the back of a steep slip face, is skipped
+// before the draw list is built
+const int meshletQuads = 4; // quads per side, 32 triangles
+
+// one array per component, padded to a multiple of 4 like BoxList
+struct MeshletBounds {
+    std::vector<float> centerX, centerY, centerZ, radius;
+    std::vector<float> axisX, axisY, axisZ;
+    std::vector<float> cutoffSquared; // sin^2 of the cone half angle, > 1 when it can't be culled
+    int count = 0;
+};
+
+struct MeshletTerrain {
+    GLuint vao, ibo;
+    MeshletBounds bounds;
+    std::vector<int> indexOffset; // first index of each meshlet, meshlets of a chunk are adjacent
+    std::vector<int> indexCount;
+    std::vector<unsigned char> visible;
+    long long triangleCount;
+
+    // draw list rebuilt every frame, adjacent visible meshlets merged
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawOffsets;
+};
+
+// gridVBO is the padded grid from createTerrainGridVBO
+MeshletTerrain createMeshletTerrain(GLuint gridVBO);
+// visible[i] becomes 1 when meshlet i is inside the frustum and has a triangle facing the camera
+void cullMeshlets(MeshletTerrain& terrain, const FrameCamera& camera);
+void drawMeshletTerrain(GLuint shaderProgram, GLuint texture, MeshletTerrain& terrain, const FrameCamera& camera);
@@ -0,0 +1,186 @@
+#include "mipChain.h"
+#include "jobSystem.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static float filterRadius(MipFilter filter) {
+    switch (filter) {
+        case MipFilterBox: return 0.5f;
+        case MipFilterTriangle: return 1.0f;
+        case MipFilterLanczos3: return 3.0f;
+        default: return 0.5f;
+    }
+}
+
+static float sinc(float x) {
+    if (std::abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+    float px = 3.14159265358979f * x;
+    return std::sin(px) / px;
+}
+
+// x is the distance in destination texels
+static float filterWeight(MipFilter filter, float x) {
+    x = std::abs(x);
+    switch (filter) {
+        case MipFilterBox: return x <= 0.5f ? 1.0f : 0.0f;
+        case MipFilterTriangle: return std::max(0.0f, 1.0f - x);
+        case MipFilterLanczos3: return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+        default: return 0.0f;
+    }
+}
+
+// normalized weights of the source texels that make up each destination texel along one
+// axis. every destination texel has tapCount taps, starting at source texel first[i]
+struct FilterTaps {
+    int tapCount;
+    std::vector<int> first;
+    std::vector<float> weights; // tapCount per destination texel
+};
+
+static FilterTaps buildTaps(MipFilter filter, int sourceSize, int destinationSize) {
+    FilterTaps taps;
+    float scale = sourceSize / (float)destinationSize;
+    float radius = filterRadius(filter) * scale;
+    taps.tapCount = (int)std::ceil(2.0f * radius) + 1;
+    taps.first.resize(destinationSize);
+    taps.weights.resize(destinationSize * taps.tapCount);
+
+    for (int i = 0; i < destinationSize; ++i) {
+        float center = (i + 0.5f) * scale;
+        int first = (int)std::floor(center - radius);
+        float* weights = &taps.weights[i * taps.tapCount];
+        float sum = 0.0f;
+        for (int t = 0; t < taps.tapCount; ++t) {
+            weights[t] = filterWeight(filter, (first + t + 0.5f - center) / scale);
+            sum += weights[t];
+        }
+        for (int t = 0; t < taps.tapCount; ++t) {
+            weights[t] /= sum;
+        }
+        taps.first[i] = first;
+    }
+    return taps;
+}
+
+static int edgeIndex(int index, int size, bool wrap) {
+    if (wrap) {
+        return ((index % size) + size) % size;
+    }
+    return std::min(std::max(index, 0), size - 1);
+}
+
+static float linearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// halves a linear RGBA float image, rows first into scratch and then columns into destination
+static void downsample(const std::vector<float>& source, int width, int height, std::vector<float>& scratch,
+                       std::vector<float>& destination, int nextWidth, int nextHeight, const MipSettings& settings) {
+    FilterTaps columns = buildTaps(settings.filter, width, nextWidth);
+    FilterTaps rows = buildTaps(settings.filter, height, nextHeight);
+    scratch.resize((size_t)nextWidth * height * 4);
+    destination.resize((size_t)nextWidth * nextHeight * 4);
+
+    parallelFor(height, 16, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const float* sourceRow = &source[(size_t)y * width * 4];
+            float* scratchRow = &scratch[(size_t)y * nextWidth * 4];
+            for (int x = 0; x < nextWidth; ++x) {
+                const float* weights = &columns.weights[x * columns.tapCount];
+                f32x4 sum = splat4(0.0f);
+                for (int t = 0; t < columns.tapCount; ++t) {
+                    int sx = edgeIndex(columns.first[x] + t, width, settings.wrap);
+                    sum = sum + splat4(weights[t]) * load4(sourceRow + sx * 4);
+                }
+                store4(scratchRow + x * 4, sum);
+            }
+        }
+    });
+
+    // negative lobes can push values out of range, clamp so the next level starts clean
+    const f32x4 zero = splat4(0.0f), one = splat4(1.0f);
+    parallelFor(nextHeight, 8, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const float* weights = &rows.weights[y * rows.tapCount];
+            float* destinationRow = &destination[(size_t)y * nextWidth * 4];
+            for (int x = 0; x < nextWidth; ++x) {
+                f32x4 sum = splat4(0.0f);
+                for (int t = 0; t < rows.tapCount; ++t) {
+                    int sy = edgeIndex(rows.first[y] + t, height, settings.wrap);
+                    sum = sum + splat4(weights[t]) * load4(&scratch[((size_t)sy * nextWidth + x) * 4]);
+                }
+                store4(destinationRow + x * 4, min4(max4(sum, zero), one));
+            }
+        }
+    });
+}
+
+std::vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int channels,
+                                    const MipSettings& settings) {
+    std::vector<MipLevel> levels;
+    levels.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * channels) });
+
+    // alpha is coverage and stays linear, the other channels are colour
+    bool colour[4];
+    for (int c = 0; c < 4; ++c) {
+        colour[c] = settings.srgb && c < channels && !(channels == 4 && c == 3);
+    }
+    float decode[256];
+    for (int i = 0; i < 256; ++i) {
+        float value = i / 255.0f;
+        decode[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // the chain is filtered from float levels so rounding errors don't pile up
+    std::vector<float> current((size_t)width * height * 4, 0.0f);
+    parallelFor(height, 16, [&](int begin, int end) {
+        for (size_t i = (size_t)begin * width; i < (size_t)end * width; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                unsigned char value = pixels[i * channels + c];
+                current[i * 4 + c] = colour[c] ? decode[value] : value / 255.0f;
+            }
+        }
+    });
+
+    std::vector<float> next, scratch;
+    while (width > 1 || height > 1) {
+        int nextWidth = std::max(1, width / 2);
+        int nextHeight = std::max(1, height / 2);
+        downsample(current, width, height, scratch, next, nextWidth, nextHeight, settings);
+
+        MipLevel level = { nextWidth, nextHeight, std::vector<unsigned char>((size_t)nextWidth * nextHeight * channels) };
+        parallelFor(nextHeight, 16, [&](int begin, int end) {
+            for (size_t i = (size_t)begin * nextWidth; i < (size_t)end * nextWidth; ++i) {
+                for (int c = 0; c < channels; ++c) {
+                    float value = next[i * 4 + c];
+                    if (colour[c]) {
+                        value = linearToSrgb(value);
+                    }
+                    level.pixels[i * channels + c] = (unsigned char)(value * 255.0f + 0.5f);
+                }
+            }
+        });
+        levels.push_back(std::move(level));
+
+        current.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return levels;
+}
+
+void uploadMipChain(const std::vector<MipLevel>& levels, GLenum format) {
+    // rows of RGB levels narrower than 4 texels aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < levels.size(); ++level) {
+        glTexImage2D(GL_TEXTURE_2D, (GLint)level, format, levels[level].width, levels[level].height, 0,
+                     format, GL_UNSIGNED_BYTE, levels[level].pixels.data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+}
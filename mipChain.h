@@ -0,0 +1,30 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+// CPU mip chain builder. levels are filtered in linear light (sRGB decoded first) with a
+// separable kernel, on the worker threads and four channels at a time with simd.h
+enum MipFilter {
+    MipFilterBox,      // 2x2 average
+    MipFilterTriangle, // tent over 4x4 source texels, a little softer
+    MipFilterLanczos3, // windowed sinc over 12x12, sharpest, may ring a little
+    MipFilterCount
+};
+
+struct MipSettings {
+    MipFilter filter = MipFilterTriangle;
+    bool srgb = true;        // colour channels hold sRGB values, alpha is always linear
+    bool wrap = true;        // the kernel wraps around the edges like GL_REPEAT, clamps otherwise
+};
+
+struct MipLevel {
+    int width, height;
+    std::vector<unsigned char> pixels; // same channel count as the source
+};
+
+// level 0 is a copy of the source, the chain goes down to 1x1
+std::vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int channels,
+                                    const MipSettings& settings = MipSettings());
+// uploads every level into the texture bound to GL_TEXTURE_2D and caps GL_TEXTURE_MAX_LEVEL
+void uploadMipChain(const std::vector<MipLevel>& levels, GLenum format);
@@ -0,0 +1,138 @@
+#include "renderQueue.h"
+#include "glState.h"
+#include "renderStats.h"
+#include <algorithm>
+#include <chrono>
+
+uint64_t makeSortKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth) {
+    const uint64_t depthMax = (1u << 24) - 1;
+    float normalized = std::clamp(depth / renderQueueFarDistance, 0.0f, 1.0f);
+    uint64_t quantized = static_cast<uint64_t>(normalized * depthMax);
+    if (pass == RenderPassTransparent) {
+        quantized = depthMax - quantized;
+    }
+
+    return (uint64_t)(pass & 0xF) << 60 |
+           (uint64_t)(program & 0xFFF) << 48 |
+           (uint64_t)(texture & 0xFFF) << 36 |
+           (uint64_t)(vertexArray & 0xFFF) << 24 |
+           quantized;
+}
+
+void submitDraw(RenderQueue& queue, uint64_t key, const DrawPacket& packet) {
+    queue.entries.push_back({ key, static_cast<uint32_t>(queue.packets.size()) });
+    queue.packets.push_back(packet);
+}
+
+void recordDraw(CommandList& list, uint64_t key, const DrawPacket& packet) {
+    list.entries.push_back({ key, static_cast<uint32_t>(list.packets.size()) });
+    list.packets.push_back(packet);
+}
+
+void mergeCommandLists(RenderQueue& queue, int listCount) {
+    for (int l = 0; l < listCount; ++l) {
+        CommandList& list = queue.lists[l];
+        uint32_t base = static_cast<uint32_t>(queue.packets.size());
+        for (const RenderQueueEntry& entry : list.entries) {
+            queue.entries.push_back({ entry.key, base + entry.packet });
+        }
+        queue.packets.insert(queue.packets.end(), list.packets.begin(), list.packets.end());
+        accumulateRenderStats(renderStats, list.stats);
+
+        list.entries.clear();
+        list.packets.clear();
+        list.stats = RenderStats();
+    }
+}
+
+// least significant byte first, 8 counting passes that keep equal keys in submission
+// order. a byte that is the same in every key doesn't need its pass
+static void radixSort(std::vector<RenderQueueEntry>& entries, std::vector<RenderQueueEntry>& scratch) {
+    size_t count = entries.size();
+    scratch.resize(count);
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = {};
+        for (const RenderQueueEntry& entry : entries) {
+            offsets[(entry.key >> shift) & 0xFF]++;
+        }
+        if (offsets[(entries[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t sum = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            size_t bucketSize = offsets[bucket];
+            offsets[bucket] = sum;
+            sum += bucketSize;
+        }
+        for (const RenderQueueEntry& entry : entries) {
+            scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+static long long trianglesOf(GLenum mode, GLsizei count) {
+    switch (mode) {
+        case GL_TRIANGLES: return count / 3;
+        case GL_TRIANGLE_STRIP: return std::max(count - 2, 0);
+        default: return 0;
+    }
+}
+
+static size_t indexSize(GLenum indexType) {
+    switch (indexType) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default: return 4;
+    }
+}
+
+void executeRenderQueue(RenderQueue& queue) {
+    if (queue.entries.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    radixSort(queue.entries, queue.scratch);
+    auto end = std::chrono::high_resolution_clock::now();
+    renderStats.queueSortMs += std::chrono::duration<float, std::milli>(end - start).count();
+    renderStats.queuePackets += static_cast<int>(queue.entries.size());
+
+    // counted here rather than by the state cache, which also sees the binds made outside the queue
+    const DrawPacket* previous = nullptr;
+    for (const RenderQueueEntry& entry : queue.entries) {
+        const DrawPacket& packet = queue.packets[entry.packet];
+        if (!previous || packet.program != previous->program) {
+            useProgram(packet.program);
+            renderStats.queueStateChanges++;
+        }
+        if (!previous || packet.texture != previous->texture) {
+            activeTexture(0);
+            bindTexture(GL_TEXTURE_2D, packet.texture);
+            renderStats.queueStateChanges++;
+        }
+        if (!previous || packet.vertexArray != previous->vertexArray) {
+            bindVertexArray(packet.vertexArray);
+            renderStats.queueStateChanges++;
+        }
+        previous = &packet;
+
+        if (packet.indexType == 0) {
+            glDrawArrays(packet.mode, packet.first, packet.count);
+        } else {
+            void* offset = (void*)(packet.first * indexSize(packet.indexType));
+            if (packet.baseVertex != 0) {
+                glDrawElementsBaseVertex(packet.mode, packet.count, packet.indexType, offset, packet.baseVertex);
+            } else {
+                glDrawElements(packet.mode, packet.count, packet.indexType, offset);
+            }
+        }
+        renderStats.drawCalls++;
+        renderStats.trianglesDrawn += trianglesOf(packet.mode, packet.count);
+    }
+
+    queue.entries.clear();
+    queue.packets.clear();
+}
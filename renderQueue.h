@@ -0,0 +1,86 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "jobSystem.h"
+#include "renderStats.h"
+
+// draws collected over the frame and issued together, sorted so that packets sharing a
+// program, texture and vertex array end up next to each other. the 64 bit key, from the
+// top bit down:
+//
+//     pass 4 | program 12 | texture 12 | vertex array 12 | depth 24
+//
+// GL names wider than their field only share a slot and batch worse, the state that
+// gets bound always comes from the packet itself
+enum RenderPass {
+    RenderPassOpaque,      // front to back
+    RenderPassTransparent, // back to front
+    RenderPassOverlay,     // debug drawing on top of everything else
+};
+
+const float renderQueueFarDistance = 1000.0f; // depths past this share the last key value
+
+// one draw call and the state it needs. indexType 0 means glDrawArrays starting at
+// vertex first, otherwise first is the first index and baseVertex is added to every index
+struct DrawPacket {
+    GLuint program;
+    GLuint texture; // GL_TEXTURE_2D on unit 0
+    GLuint vertexArray;
+    GLenum mode;
+    GLenum indexType;
+    GLsizei count;
+    GLint first;
+    GLint baseVertex;
+};
+
+struct RenderQueueEntry {
+    uint64_t key;
+    uint32_t packet; // index into the packets next to it
+};
+
+// packets recorded by one worker thread, touching nothing shared. the counters go to
+// stats instead of renderStats and are added to it when the list is merged
+struct CommandList {
+    std::vector<DrawPacket> packets;
+    std::vector<RenderQueueEntry> entries;
+    RenderStats stats;
+};
+
+struct RenderQueue {
+    std::vector<DrawPacket> packets;
+    std::vector<RenderQueueEntry> entries;
+    std::vector<RenderQueueEntry> scratch; // radix sort ping-pong buffer
+    std::vector<CommandList> lists;        // kept between frames so their storage is reused
+};
+
+uint64_t makeSortKey(RenderPass pass, GLuint program, GLuint texture, GLuint vertexArray, float depth);
+// GL thread only
+void submitDraw(RenderQueue& queue, uint64_t key, const DrawPacket& packet);
+// any thread, one thread per list
+void recordDraw(CommandList& list, uint64_t key, const DrawPacket& packet);
+// appends the first listCount lists to the queue in order and empties them
+void mergeCommandLists(RenderQueue& queue, int listCount);
+// sorts by key, issues every packet and empties the queue
+void executeRenderQueue(RenderQueue& queue);
+
+// calls record(list, begin, end) over [0, count) on the worker threads, every range of
+// grain items with a command list of its own, then merges the lists in range order so the
+// queue looks the same as if everything had been recorded on the calling thread
+template <class Record>
+void recordParallel(RenderQueue& queue, int count, int grain, Record&& record) {
+    auto start = std::chrono::high_resolution_clock::now();
+    int listCount = (count + grain - 1) / grain;
+    if ((int)queue.lists.size() < listCount) {
+        queue.lists.resize(listCount);
+    }
+    // parallelFor hands out ranges starting at multiples of grain
+    parallelFor(count, grain, [&](int begin, int end) {
+        record(queue.lists[begin / grain], begin, end);
+    });
+    mergeCommandLists(queue, listCount);
+    auto end = std::chrono::high_resolution_clock::now();
+    renderStats.queueRecordMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
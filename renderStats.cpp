@@ -0,0 +1,71 @@
+#include "renderStats.h"
+#include "jobSystem.h"
+#include <iostream>
+
+RenderStats renderStats;
+
+// accumulated over the reporting interval so the printout shows averages
+static RenderStats accumulated;
+static int accumulatedFrames = 0;
+static float accumulatedTime = 0.0f;
+
+void resetRenderStats() {
+    renderStats = RenderStats();
+}
+
+void accumulateRenderStats(RenderStats& total, const RenderStats& frame) {
+    total.chunksSubmitted += frame.chunksSubmitted;
+    total.drawCalls += frame.drawCalls;
+    total.glCallsIssued += frame.glCallsIssued;
+    total.glCallsElided += frame.glCallsElided;
+    total.chunksCulled += frame.chunksCulled;
+    total.chunksOccluded += frame.chunksOccluded;
+    total.trianglesDrawn += frame.trianglesDrawn;
+    total.trianglesConeCulled += frame.trianglesConeCulled;
+    total.selectionMs += frame.selectionMs;
+    total.occlusionMs += frame.occlusionMs;
+    total.texelsUploaded += frame.texelsUploaded;
+    total.textureBytesUploaded += frame.textureBytesUploaded;
+    total.queuePackets += frame.queuePackets;
+    total.queueStateChanges += frame.queueStateChanges;
+    total.queueSortMs += frame.queueSortMs;
+    total.queueRecordMs += frame.queueRecordMs;
+    total.bytesStreamed += frame.bytesStreamed;
+    total.streamWaitMs += frame.streamWaitMs;
+}
+
+void reportRenderStats(float dt) {
+    accumulateRenderStats(accumulated, renderStats);
+    accumulatedFrames++;
+    accumulatedTime += dt;
+
+    if (accumulatedTime < 1.0f) {
+        return;
+    }
+
+    float frames = static_cast<float>(accumulatedFrames);
+    std::cout << "frame " << accumulatedTime / frames * 1000.0f << " ms"
+              << " | draw calls " << accumulated.drawCalls / frames
+              << " | state calls " << accumulated.glCallsIssued / frames
+              << " elided " << accumulated.glCallsElided / frames
+              << " | chunks submitted " << accumulated.chunksSubmitted / frames
+              << " culled " << accumulated.chunksCulled / frames
+              << " occluded " << accumulated.chunksOccluded / frames
+              << " in " << accumulated.occlusionMs / frames << " ms"
+              << " | triangles " << accumulated.trianglesDrawn / frames
+              << " cone culled " << accumulated.trianglesConeCulled / frames
+              << " | lod selection " << accumulated.selectionMs / frames << " ms"
+              << " | queue " << accumulated.queuePackets / frames << " packets"
+              << " recorded in " << accumulated.queueRecordMs / frames << " ms on " << jobWorkerCount() + 1 << " threads"
+              << " sorted in " << accumulated.queueSortMs / frames << " ms"
+              << " state changes " << accumulated.queueStateChanges / frames
+              << " | texels uploaded " << accumulated.texelsUploaded / frames
+              << " texture bytes " << accumulated.textureBytesUploaded / frames
+              << " | streamed " << accumulated.bytesStreamed / frames << " bytes"
+              << " waited " << accumulated.streamWaitMs / frames << " ms"
+              << std::endl;
+
+    accumulated = RenderStats();
+    accumulatedFrames = 0;
+    accumulatedTime = 0.0f;
+}
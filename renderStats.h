@@ -0,0 +1,30 @@
+#pragma once
+
+// per frame counters, reset at the start of every frame and printed once per second
+struct RenderStats {
+    int chunksSubmitted = 0;
+    int drawCalls = 0;
+    int glCallsIssued = 0; // state changes that went through the state cache to GL
+    int glCallsElided = 0; // state changes the cache dropped as redundant
+    int chunksCulled = 0;
+    int chunksOccluded = 0; // part of chunksCulled, in the frustum but behind the horizon
+    long long trianglesDrawn = 0;
+    long long trianglesConeCulled = 0; // facing away, skipped by normal cone culling
+    float selectionMs = 0.0f;
+    float occlusionMs = 0.0f;
+    long long texelsUploaded = 0;
+    long long textureBytesUploaded = 0; // texture loader copies through its pixel buffer
+    int queuePackets = 0;
+    int queueStateChanges = 0; // program, texture and vertex array switches between sorted packets
+    float queueSortMs = 0.0f;
+    float queueRecordMs = 0.0f; // filling command lists on the workers and merging them
+    long long bytesStreamed = 0;
+    float streamWaitMs = 0.0f; // CPU blocked on stream buffer fences
+};
+
+extern RenderStats renderStats;
+
+void resetRenderStats();
+// adds every counter of frame to total
+void accumulateRenderStats(RenderStats& total, const RenderStats& frame);
+void reportRenderStats(float dt);
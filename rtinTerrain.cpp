@@ -0,0 +1,231 @@
+#include "rtinTerrain.h"
+#include "glState.h"
+#include "jobSystem.h"
+#include "renderStats.h"
+#include "terrainGrid.h"
+#include "vertexCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+const int rtinTriangles = (rtinTileSize - 1) * (rtinTileSize - 1) * 2 - 2;
+const int rtinParentTriangles = rtinTriangles - (rtinTileSize - 1) * (rtinTileSize - 1);
+
+// hypotenuse end points (ax, ay, bx, by) of every triangle in the hierarchy, children
+// come after their parents. triangle ids follow the binary path from the two roots
+static std::vector<unsigned short> buildTriangleCoords() {
+    const int last = rtinTileSize - 1;
+    std::vector<unsigned short> coords(rtinTriangles * 4);
+
+    for (int i = 0; i < rtinTriangles; ++i) {
+        int id = i + 2;
+        int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1) {
+            bx = by = cx = last; // bottom-left root
+        } else {
+            ax = ay = cy = last; // top-right root
+        }
+        while ((id >>= 1) > 1) {
+            int mx = (ax + bx) >> 1;
+            int my = (ay + by) >> 1;
+            if (id & 1) { // left half
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {      // right half
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx; cy = my;
+        }
+        coords[i * 4 + 0] = ax;
+        coords[i * 4 + 1] = ay;
+        coords[i * 4 + 2] = bx;
+        coords[i * 4 + 3] = by;
+    }
+    return coords;
+}
+
+// error[y * size + x] becomes the largest error of the vertex and of everything below it in the hierarchy
+static void propagateErrors(const std::vector<unsigned short>& coords, float* errors) {
+    for (int i = rtinParentTriangles - 1; i >= 0; --i) {
+        int ax = coords[i * 4 + 0], ay = coords[i * 4 + 1];
+        int bx = coords[i * 4 + 2], by = coords[i * 4 + 3];
+        int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+        int cx = mx + my - ay, cy = my + ax - mx;
+
+        int middle = my * rtinTileSize + mx;
+        int leftChild = ((ay + cy) >> 1) * rtinTileSize + ((ax + cx) >> 1);
+        int rightChild = ((by + cy) >> 1) * rtinTileSize + ((bx + cx) >> 1);
+        errors[middle] = std::max(errors[middle], std::max(errors[leftChild], errors[rightChild]));
+    }
+}
+
+static void computeErrors(const std::vector<unsigned short>& coords, const TerrainChunk& chunk, float* errors) {
+    auto height = [&](int x, int y) {
+        return gridHeight(chunk.x0 + x, chunk.z0 + y);
+    };
+
+    std::fill(errors, errors + rtinTileSize * rtinTileSize, 0.0f);
+    for (int i = rtinTriangles - 1; i >= 0; --i) {
+        int ax = coords[i * 4 + 0], ay = coords[i * 4 + 1];
+        int bx = coords[i * 4 + 2], by = coords[i * 4 + 3];
+        int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+
+        float interpolated = (height(ax, ay) + height(bx, by)) * 0.5f;
+        float& error = errors[my * rtinTileSize + mx];
+        error = std::max(error, std::abs(interpolated - height(mx, my)));
+    }
+    propagateErrors(coords, errors);
+}
+
+// walks down from the two roots, emitting a triangle wherever its error is small enough
+static void extractTriangles(const TerrainChunk& chunk, const float* errors, float maxError, std::vector<unsigned int>& indices) {
+    struct Triangle { int ax, ay, bx, by, cx, cy; };
+    const int last = rtinTileSize - 1;
+
+    Triangle stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0, last, last, last, 0 };
+    stack[stackSize++] = { last, last, 0, 0, 0, last };
+
+    while (stackSize > 0) {
+        Triangle t = stack[--stackSize];
+        int mx = (t.ax + t.bx) >> 1;
+        int my = (t.ay + t.by) >> 1;
+
+        if (std::abs(t.ax - t.cx) + std::abs(t.ay - t.cy) > 1 && errors[my * rtinTileSize + mx] > maxError) {
+            stack[stackSize++] = { t.bx, t.by, t.cx, t.cy, mx, my };
+            stack[stackSize++] = { t.cx, t.cy, t.ax, t.ay, mx, my };
+            continue;
+        }
+
+        // padding vertices collapse onto the map edge, drop what becomes flat there
+        int ax = std::min(chunk.x0 + t.ax, fineSize - 1), az = std::min(chunk.z0 + t.ay, fineSize - 1);
+        int bx = std::min(chunk.x0 + t.bx, fineSize - 1), bz = std::min(chunk.z0 + t.by, fineSize - 1);
+        int cx = std::min(chunk.x0 + t.cx, fineSize - 1), cz = std::min(chunk.z0 + t.cy, fineSize - 1);
+        if ((bx - ax) * (cz - az) - (bz - az) * (cx - ax) == 0) {
+            continue;
+        }
+        indices.push_back(gridIndex(ax, az));
+        indices.push_back(gridIndex(bx, bz));
+        indices.push_back(gridIndex(cx, cz));
+    }
+}
+
+// neighbouring tiles share their edge vertices but see different triangles behind them,
+// so an edge vertex could be split on one side only. taking the larger error on both
+// sides and propagating again makes both tiles agree on every edge, leaving no cracks
+static void mergeEdgeErrors(std::vector<float>& errors) {
+    const int tileArea = rtinTileSize * rtinTileSize;
+    const int last = rtinTileSize - 1;
+
+    for (int cz = 0; cz < chunksPerSide; ++cz) {
+        for (int cx = 0; cx < chunksPerSide; ++cx) {
+            float* tile = &errors[(cz * chunksPerSide + cx) * tileArea];
+            if (cx + 1 < chunksPerSide) {
+                float* east = &errors[(cz * chunksPerSide + cx + 1) * tileArea];
+                for (int y = 0; y < rtinTileSize; ++y) {
+                    float error = std::max(tile[y * rtinTileSize + last], east[y * rtinTileSize]);
+                    tile[y * rtinTileSize + last] = east[y * rtinTileSize] = error;
+                }
+            }
+            if (cz + 1 < chunksPerSide) {
+                float* south = &errors[((cz + 1) * chunksPerSide + cx) * tileArea];
+                for (int x = 0; x < rtinTileSize; ++x) {
+                    float error = std::max(tile[last * rtinTileSize + x], south[x]);
+                    tile[last * rtinTileSize + x] = south[x] = error;
+                }
+            }
+        }
+    }
+}
+
+RtinTerrain createRtinTerrain(GLuint gridVBO, float maxError) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    RtinTerrain terrain;
+    terrain.maxError = maxError;
+
+    TerrainChunkGrid chunks = createTerrainChunks();
+    int chunkCount = static_cast<int>(chunks.chunks.size());
+    const int tileArea = rtinTileSize * rtinTileSize;
+
+    std::vector<unsigned short> coords = buildTriangleCoords();
+    std::vector<float> errors(chunkCount * tileArea);
+    terrain.chunkIndices.resize(chunkCount);
+
+    parallelFor(chunkCount, 1, [&](int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            computeErrors(coords, chunks.chunks[c], &errors[c * tileArea]);
+        }
+    });
+
+    mergeEdgeErrors(errors);
+
+    // extraction emits triangles in hierarchy order, reorder each chunk for the vertex cache
+    std::vector<VertexCacheStats> cacheBefore(chunkCount), cacheAfter(chunkCount);
+    parallelFor(chunkCount, 1, [&](int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            propagateErrors(coords, &errors[c * tileArea]);
+            std::vector<unsigned int>& chunkIndices = terrain.chunkIndices[c];
+            extractTriangles(chunks.chunks[c], &errors[c * tileArea], maxError, chunkIndices);
+
+            int count = static_cast<int>(chunkIndices.size());
+            cacheBefore[c] = simulateVertexCache(chunkIndices.data(), count);
+            optimizeVertexCache(chunkIndices.data(), count);
+            cacheAfter[c] = simulateVertexCache(chunkIndices.data(), count);
+        }
+    });
+
+    std::vector<unsigned int> indices;
+    VertexCacheStats totalBefore, totalAfter;
+    terrain.triangleCount = 0;
+    for (int c = 0; c < chunkCount; ++c) {
+        totalBefore += cacheBefore[c];
+        totalAfter += cacheAfter[c];
+        terrain.chunkOffset.push_back(static_cast<int>(indices.size()));
+        terrain.chunkCount.push_back(static_cast<int>(terrain.chunkIndices[c].size()));
+        indices.insert(indices.end(), terrain.chunkIndices[c].begin(), terrain.chunkIndices[c].end());
+        terrain.triangleCount += terrain.chunkIndices[c].size() / 3;
+    }
+
+    glGenBuffers(1, &terrain.ibo);
+    terrain.vao = createTerrainGridVAO(gridVBO, terrain.ibo);
+    bindVertexArray(terrain.vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    bindVertexArray(0);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    long long gridTriangles = 2LL * (fineSize - 1) * (fineSize - 1);
+    std::cout << "rtin: " << terrain.triangleCount << " triangles for max error " << maxError
+              << " vs " << gridTriangles << " in the regular grid ("
+              << 100.0 * (1.0 - (double)terrain.triangleCount / gridTriangles) << "% fewer), built in "
+              << std::chrono::duration<float, std::milli>(end - start).count() << " ms on "
+              << jobWorkerCount() + 1 << " threads" << std::endl;
+    std::cout << "rtin vertex cache: ACMR " << totalBefore.acmr() << " -> " << totalAfter.acmr()
+              << ", vertex shader invocations " << totalBefore.vertexShaderInvocations
+              << " -> " << totalAfter.vertexShaderInvocations << std::endl;
+
+    return terrain;
+}
+
+void submitRtinTerrain(RenderQueue& queue, GLuint shaderProgram, GLuint texture, RtinTerrain& terrain, TerrainChunkGrid& grid, const FrameCamera& camera) {
+    cullTerrainChunks(grid, camera);
+
+    recordParallel(queue, static_cast<int>(grid.chunks.size()), 16, [&](CommandList& list, int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            if (!grid.visible[c]) {
+                list.stats.chunksCulled++;
+                continue;
+            }
+            const TerrainChunk& chunk = grid.chunks[c];
+            glm::vec3 center = 0.5f * (chunk.boundsMin + chunk.boundsMax);
+            DrawPacket packet = { shaderProgram, texture, terrain.vao, GL_TRIANGLES, GL_UNSIGNED_INT,
+                                  terrain.chunkCount[c], terrain.chunkOffset[c], 0 };
+            recordDraw(list, makeSortKey(RenderPassOpaque, shaderProgram, texture, terrain.vao,
+                                         glm::distance(center, camera.position)), packet);
+            list.stats.chunksSubmitted++;
+        }
+    });
+}
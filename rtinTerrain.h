@@ -0,0 +1,24 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "renderQueue.h"
+#include "terrainChunks.h"
+
+// right-triangulated irregular network (Martini style) built per chunk: triangles are
+// split along their hypotenuse only while the midpoint height is further than
+// maxError from the interpolated edge, so flat dune areas end up with few triangles
+const int rtinTileSize = chunkQuads + 1; // must be 2^n + 1
+
+struct RtinTerrain {
+    GLuint vao, ibo;
+    float maxError;
+    std::vector<int> chunkOffset; // first index of each chunk in the index buffer
+    std::vector<int> chunkCount;
+    std::vector<std::vector<unsigned int>> chunkIndices; // global grid indices, kept for later passes
+    long long triangleCount;
+};
+
+// gridVBO is the padded grid from createTerrainGridVBO
+RtinTerrain createRtinTerrain(GLuint gridVBO, float maxError);
+void submitRtinTerrain(RenderQueue& queue, GLuint shaderProgram, GLuint texture, RtinTerrain& terrain, TerrainChunkGrid& grid, const FrameCamera& camera);
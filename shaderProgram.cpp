@@ -0,0 +1,204 @@
+#include "shaderProgram.h"
+#include <cstring>
+#include <iostream>
+
+static GLuint compileShader(GLenum stage, const char* source, const char* stageName) {
+    GLuint shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "Error compiling " << stageName << " shader\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+// array uniforms come back as "name[0]", handles are looked up by the bare name
+static std::string baseName(const char* name) {
+    const char* bracket = std::strchr(name, '[');
+    return bracket ? std::string(name, bracket) : std::string(name);
+}
+
+static void reflectProgram(ShaderProgram& shader) {
+    char name[256];
+    GLint count = 0;
+
+    glGetProgramiv(shader.program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        ShaderVariable uniform;
+        glGetActiveUniform(shader.program, i, sizeof(name), NULL, &uniform.size, &uniform.type, name);
+        uniform.name = baseName(name);
+        // uniform block members have no location of their own
+        uniform.location = glGetUniformLocation(shader.program, name);
+        shader.uniforms.push_back(uniform);
+    }
+
+    glGetProgramiv(shader.program, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count; ++i) {
+        ShaderVariable attribute;
+        glGetActiveAttrib(shader.program, i, sizeof(name), NULL, &attribute.size, &attribute.type, name);
+        attribute.name = baseName(name);
+        attribute.location = glGetAttribLocation(shader.program, name);
+        shader.attributes.push_back(attribute);
+    }
+
+    glGetProgramiv(shader.program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        ShaderBlock block;
+        glGetActiveUniformBlockName(shader.program, i, sizeof(name), NULL, name);
+        block.name = name;
+        block.index = i;
+        glGetActiveUniformBlockiv(shader.program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+        shader.uniformBlocks.push_back(block);
+    }
+}
+
+// links the attached stages, reflects the program on success and deletes the stages
+static ShaderProgram linkProgram(const GLuint* stages, int stageCount) {
+    ShaderProgram shader;
+    shader.program = glCreateProgram();
+    for (int i = 0; i < stageCount; ++i) {
+        glAttachShader(shader.program, stages[i]);
+    }
+    glLinkProgram(shader.program);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(shader.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shader.program, 512, NULL, infoLog);
+        std::cerr << "Error linking shader program\n" << infoLog << std::endl;
+    }
+
+    for (int i = 0; i < stageCount; ++i) {
+        glDeleteShader(stages[i]);
+    }
+
+    if (success) {
+        reflectProgram(shader);
+    }
+    return shader;
+}
+
+ShaderProgram createShaderProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint stages[] = {
+        compileShader(GL_VERTEX_SHADER, vertexSource, "vertex"),
+        compileShader(GL_FRAGMENT_SHADER, fragmentSource, "fragment"),
+    };
+    return linkProgram(stages, 2);
+}
+
+ShaderProgram createComputeProgram(const char* computeSource) {
+    GLuint stage = compileShader(GL_COMPUTE_SHADER, computeSource, "compute");
+    return linkProgram(&stage, 1);
+}
+
+ShaderProgram createTessellationProgram(const char* vertexSource, const char* controlSource,
+                                        const char* evaluationSource, const char* fragmentSource) {
+    GLuint stages[] = {
+        compileShader(GL_VERTEX_SHADER, vertexSource, "vertex"),
+        compileShader(GL_TESS_CONTROL_SHADER, controlSource, "tessellation control"),
+        compileShader(GL_TESS_EVALUATION_SHADER, evaluationSource, "tessellation evaluation"),
+        compileShader(GL_FRAGMENT_SHADER, fragmentSource, "fragment"),
+    };
+    return linkProgram(stages, 4);
+}
+
+template <class T> static bool acceptsType(GLenum type);
+template <> bool acceptsType<float>(GLenum type) { return type == GL_FLOAT; }
+template <> bool acceptsType<glm::vec2>(GLenum type) { return type == GL_FLOAT_VEC2; }
+template <> bool acceptsType<glm::vec3>(GLenum type) { return type == GL_FLOAT_VEC3; }
+template <> bool acceptsType<glm::ivec2>(GLenum type) { return type == GL_INT_VEC2; }
+template <> bool acceptsType<glm::mat4>(GLenum type) { return type == GL_FLOAT_MAT4; }
+template <> bool acceptsType<int>(GLenum type) {
+    switch (type) {
+        case GL_INT:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_IMAGE_2D:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <class T>
+Uniform<T> findUniform(const ShaderProgram& shader, const char* name) {
+    Uniform<T> handle;
+    for (const ShaderVariable& uniform : shader.uniforms) {
+        if (uniform.name != name) {
+            continue;
+        }
+        if (!acceptsType<T>(uniform.type)) {
+            std::cerr << "Error::Uniform '" << name << "' of program " << shader.program
+                      << " has GL type 0x" << std::hex << uniform.type << std::dec << ", not the one it is set with\n";
+            return handle;
+        }
+        handle.location = uniform.location;
+        return handle;
+    }
+    std::cerr << "Error::Uniform '" << name << "' not found in program " << shader.program << "\n";
+    return handle;
+}
+
+template Uniform<int> findUniform<int>(const ShaderProgram&, const char*);
+template Uniform<float> findUniform<float>(const ShaderProgram&, const char*);
+template Uniform<glm::vec2> findUniform<glm::vec2>(const ShaderProgram&, const char*);
+template Uniform<glm::vec3> findUniform<glm::vec3>(const ShaderProgram&, const char*);
+template Uniform<glm::ivec2> findUniform<glm::ivec2>(const ShaderProgram&, const char*);
+template Uniform<glm::mat4> findUniform<glm::mat4>(const ShaderProgram&, const char*);
+
+GLint findAttribute(const ShaderProgram& shader, const char* name) {
+    for (const ShaderVariable& attribute : shader.attributes) {
+        if (attribute.name == name) {
+            return attribute.location;
+        }
+    }
+    return -1;
+}
+
+const ShaderBlock* findUniformBlock(const ShaderProgram& shader, const char* name) {
+    for (const ShaderBlock& block : shader.uniformBlocks) {
+        if (block.name == name) {
+            return &block;
+        }
+    }
+    return nullptr;
+}
+
+void setUniform(Uniform<int> uniform, int value) {
+    glUniform1i(uniform.location, value);
+}
+
+void setUniform(Uniform<float> uniform, float value) {
+    glUniform1f(uniform.location, value);
+}
+
+void setUniform(Uniform<glm::vec2> uniform, glm::vec2 value) {
+    glUniform2f(uniform.location, value.x, value.y);
+}
+
+void setUniform(Uniform<glm::vec3> uniform, glm::vec3 value) {
+    glUniform3f(uniform.location, value.x, value.y, value.z);
+}
+
+void setUniform(Uniform<glm::ivec2> uniform, glm::ivec2 value) {
+    glUniform2i(uniform.location, value.x, value.y);
+}
+
+void setUniform(Uniform<glm::mat4> uniform, const glm::mat4& value) {
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value[0][0]);
+}
+
+void setUniform(Uniform<glm::vec2> uniform, const glm::vec2* values, int count) {
+    glUniform2fv(uniform.location, count, &values[0].x);
+}
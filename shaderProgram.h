@@ -0,0 +1,64 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// an active uniform or vertex attribute as reported by the driver after linking.
+// arrays are listed once under their name without the [0]
+struct ShaderVariable {
+    std::string name;
+    GLint location;
+    GLenum type; // GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+    GLint size;  // array length, 1 for plain variables
+};
+
+// a uniform block, its members are filled from a buffer bound to the block's binding point
+struct ShaderBlock {
+    std::string name;
+    GLuint index;
+    GLint dataSize; // bytes the buffer range has to cover
+};
+
+// a linked program plus everything it exposes, queried once so nothing on the
+// hot path has to look a uniform up by name
+struct ShaderProgram {
+    GLuint program;
+    std::vector<ShaderVariable> uniforms;
+    std::vector<ShaderVariable> attributes;
+    std::vector<ShaderBlock> uniformBlocks;
+};
+
+// location of a uniform whose GLSL type was checked against T when it was looked up.
+// a uniform the program doesn't have stays at -1, which GL silently ignores
+template <class T>
+struct Uniform {
+    GLint location = -1;
+};
+
+// compiles, links and reflects, compile and link errors go to std::cerr
+ShaderProgram createShaderProgram(const char* vertexSource, const char* fragmentSource);
+// same for a single compute shader, needs GL 4.3 or ARB_compute_shader
+ShaderProgram createComputeProgram(const char* computeSource);
+// vertex, tessellation control, tessellation evaluation and fragment stages, needs GL 4.0
+ShaderProgram createTessellationProgram(const char* vertexSource, const char* controlSource,
+                                        const char* evaluationSource, const char* fragmentSource);
+
+// reports a missing uniform or a type mismatch once, here, instead of on every set.
+// int handles also accept samplers and images, which are set to a texture or image unit
+template <class T>
+Uniform<T> findUniform(const ShaderProgram& shader, const char* name);
+// -1 when the attribute is not active
+GLint findAttribute(const ShaderProgram& shader, const char* name);
+// nullptr when the program has no such block
+const ShaderBlock* findUniformBlock(const ShaderProgram& shader, const char* name);
+
+// the program has to be in use
+void setUniform(Uniform<int> uniform, int value);
+void setUniform(Uniform<float> uniform, float value);
+void setUniform(Uniform<glm::vec2> uniform, glm::vec2 value);
+void setUniform(Uniform<glm::vec3> uniform, glm::vec3 value);
+void setUniform(Uniform<glm::ivec2> uniform, glm::ivec2 value);
+void setUniform(Uniform<glm::mat4> uniform, const glm::mat4& value);
+void setUniform(Uniform<glm::vec2> uniform, const glm::vec2* values, int count);
@@ -0,0 +1,38 @@
+#version 330 core
+
+    layout(location = 0) in vec2 aGridPos; // [0, 1] across the patch
+    layout(location = 2) in vec4 aNode;    // x, z corner in height map units, size, lod
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform sampler2D heightSampler;
+    uniform vec2 morphRange[8]; // start and end distance of the morph, per lod
+    uniform float gridDimension;
+    uniform float mapSize;
+
+    out vec2 vertexUV;
+
+    // height map coordinates to the same world space as createTexturedTerrainVAO
+    vec3 worldPosition(vec2 mapPos) {
+        float height = texture(heightSampler, (mapPos + 0.5) / mapSize).r;
+        float offset = mapSize / 2.0;
+        return vec3(mapPos.x - offset, height, -(mapPos.y - offset));
+    }
+
+    void main(){
+        vec2 mapPos = min(aNode.xy + aGridPos * aNode.z, vec2(mapSize - 1.0));
+        float distanceToCamera = distance(worldPosition(mapPos), cameraPosition.xyz);
+        vec2 range = morphRange[int(aNode.w)];
+        float morph = clamp((distanceToCamera - range.x) / (range.y - range.x), 0.0, 1.0);
+
+        // slide odd vertices onto the next coarser grid as the node nears the end of its range
+        vec2 oddOffset = fract(aGridPos * gridDimension * 0.5) * 2.0 / gridDimension;
+        mapPos = min(aNode.xy + (aGridPos - oddOffset * morph) * aNode.z, vec2(mapSize - 1.0));
+
+        vertexUV = mapPos / (mapSize - 1.0) * 10.0;
+        gl_Position = viewProjection * vec4(worldPosition(mapPos), 1.0);
+    }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 330 core
+
+    layout(location = 0) in vec2 aGridPos; // vertex inside the level, 0 .. grid size
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform sampler2DArray heightSampler; // one toroidally addressed layer per level
+    uniform int level;
+    uniform int levelCount;
+    uniform int textureSize;
+    uniform ivec2 levelOrigin;  // first vertex of this level, in its own vertex units
+    uniform vec2 cameraGridPos; // camera x, z in this level's vertex units
+    uniform float spacing;
+    uniform float transitionStart;
+    uniform float transitionWidth;
+    uniform float mapSize;
+
+    out vec2 vertexUV;
+
+    // vertex positions can be negative, the bias keeps % on non-negative values
+    float fetchHeight(ivec2 gridPos, int layer) {
+        ivec2 texel = (gridPos + textureSize * 1024) % textureSize;
+        return texelFetch(heightSampler, ivec3(texel, layer), 0).r;
+    }
+
+    void main(){
+        ivec2 gridPos = levelOrigin + ivec2(aGridPos);
+        float height = fetchHeight(gridPos, level);
+
+        // blend towards the next coarser level near the outer edge, so the
+        // boundary vertices line up with the ring around this one
+        if (level + 1 < levelCount) {
+            ivec2 c0 = gridPos >> 1;
+            ivec2 c1 = (gridPos + 1) >> 1;
+            float coarse = 0.25 * (fetchHeight(ivec2(c0.x, c0.y), level + 1) + fetchHeight(ivec2(c1.x, c0.y), level + 1) +
+                                   fetchHeight(ivec2(c0.x, c1.y), level + 1) + fetchHeight(ivec2(c1.x, c1.y), level + 1));
+            vec2 alpha = clamp((abs(vec2(gridPos) - cameraGridPos) - transitionStart) / transitionWidth, 0.0, 1.0);
+            height = mix(height, coarse, max(alpha.x, alpha.y));
+        }
+
+        vec3 worldPosition = vec3(gridPos.x * spacing, height, gridPos.y * spacing);
+
+        // same texture coordinates as createTexturedTerrainVAO
+        vec2 mapPos = vec2(worldPosition.x + mapSize / 2.0, -worldPosition.z + mapSize / 2.0);
+        vertexUV = mapPos / (mapSize - 1.0) * 10.0;
+
+        gl_Position = viewProjection * vec4(worldPosition, 1.0);
+    }
\ No newline at end of file
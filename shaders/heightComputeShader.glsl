@@ -0,0 +1,43 @@
+#version 430 core
+
+    // one invocation per height map texel, same math as generateHeightMap
+    layout(local_size_x = 8, local_size_y = 8) in;
+
+    layout(r32f) uniform writeonly image2D heightImage;
+    uniform sampler2D controlSampler; // texel (x, z) is controlPoints[z][x]
+    uniform int fineSize;
+    uniform int controlSize;
+
+    float catmullRom(float p0, float p1, float p2, float p3, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5 * (
+            2.0 * p1 +
+            (-p0 + p2) * t +
+            (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 +
+            (-p0 + 3.0 * p1 - 3.0 * p2 + p3) * t3
+        );
+    }
+
+    float control(ivec2 index, int x, int z) {
+        return texelFetch(controlSampler, index + ivec2(x, z), 0).r;
+    }
+
+    void main(){
+        ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+        if (texel.x >= fineSize || texel.y >= fineSize) {
+            return;
+        }
+
+        vec2 ratio = vec2(texel) / float(fineSize - 1) * float(controlSize - 3);
+        ivec2 index = min(ivec2(ratio), ivec2(controlSize - 4));
+        vec2 t = ratio - vec2(index);
+
+        float col[4];
+        for (int i = 0; i < 4; ++i) {
+            col[i] = catmullRom(control(index, 0, i), control(index, 1, i), control(index, 2, i), control(index, 3, i), t.x);
+        }
+
+        float height = catmullRom(col[0], col[1], col[2], col[3], t.y);
+        imageStore(heightImage, texel, vec4(height));
+    }
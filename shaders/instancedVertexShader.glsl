@@ -0,0 +1,28 @@
+#version 330 core
+
+    layout(location = 0) in vec2 aGridPos;  // vertex inside the chunk, 0 .. chunk quads
+    layout(location = 2) in vec4 aInstance; // x0, z0 of the chunk in height map vertices, height layer, unused
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform sampler2DArray heightSampler; // one layer per chunk
+    uniform float mapSize;
+
+    out vec2 vertexUV;
+
+    void main(){
+        float height = texelFetch(heightSampler, ivec3(ivec2(aGridPos), int(aInstance.z)), 0).r;
+
+        // padding vertices past the map edge collapse onto it, as in the grid VBO
+        vec2 mapPos = min(aInstance.xy + aGridPos, vec2(mapSize - 1.0));
+        float offset = mapSize / 2.0;
+        vec3 worldPosition = vec3(mapPos.x - offset, height, -(mapPos.y - offset));
+
+        // same texture coordinates as createTexturedTerrainVAO
+        vertexUV = mapPos / (mapSize - 1.0) * 10.0;
+        gl_Position = viewProjection * vec4(worldPosition, 1.0);
+    }
@@ -0,0 +1,71 @@
+#version 330 core
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform sampler2D controlSampler; // texel (x, z) is controlPoints[z][x]
+    uniform int controlSize;
+    uniform float mapSize;
+    uniform int resolution; // grid vertices per side
+
+    out vec2 vertexUV;
+
+    float catmullRom(float p0, float p1, float p2, float p3, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5 * (
+            2.0 * p1 +
+            (-p0 + p2) * t +
+            (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 +
+            (-p0 + 3.0 * p1 - 3.0 * p2 + p3) * t3
+        );
+    }
+
+    float control(ivec2 index, int x, int z) {
+        return texelFetch(controlSampler, index + ivec2(x, z), 0).r;
+    }
+
+    // generateHeightMap at any point of the map, not just at height map texels
+    float splineHeight(vec2 gridPos) {
+        vec2 ratio = gridPos * float(controlSize - 3);
+        ivec2 index = min(ivec2(ratio), ivec2(controlSize - 4));
+        vec2 t = ratio - vec2(index);
+
+        float col[4];
+        for (int i = 0; i < 4; ++i) {
+            col[i] = catmullRom(control(index, 0, i), control(index, 1, i), control(index, 2, i), control(index, 3, i), t.x);
+        }
+        return catmullRom(col[0], col[1], col[2], col[3], t.y);
+    }
+
+    // strip order of splineTerrain.cpp: a row alternates between grid rows row and
+    // row + 1, then repeats its last vertex and the next row's first one
+    vec2 stripGridPos(int id) {
+        int rowLength = 2 * resolution + 2;
+        int row = id / rowLength;
+        int k = id - row * rowLength;
+        ivec2 vertex;
+        if (k < 2 * resolution) {
+            vertex = ivec2(k / 2, row + (k & 1));
+        } else if (k == 2 * resolution) {
+            vertex = ivec2(resolution - 1, row + 1);
+        } else {
+            vertex = ivec2(0, row + 1);
+        }
+        return vec2(vertex) / float(resolution - 1);
+    }
+
+    void main(){
+        vec2 gridPos = stripGridPos(gl_VertexID); // [0, 1] across the map
+
+        // same world space and texture coordinates as createTexturedTerrainVAO
+        vec2 mapPos = gridPos * (mapSize - 1.0);
+        float offset = mapSize / 2.0;
+        vec3 worldPosition = vec3(mapPos.x - offset, splineHeight(gridPos), -(mapPos.y - offset));
+
+        vertexUV = gridPos * 10.0;
+        gl_Position = viewProjection * vec4(worldPosition, 1.0);
+    }
@@ -0,0 +1,41 @@
+#version 400 core
+
+    layout(vertices = 4) out;
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform float viewportHeight;
+    uniform float pixelsPerEdge; // target length of a tessellated edge on screen
+
+    in vec3 controlPosition[];
+    in vec2 controlUV[];
+    out vec3 evaluationPosition[];
+    out vec2 evaluationUV[];
+
+    // projected diameter of the sphere around the edge. it only depends on the edge, so
+    // the two patches sharing it agree on the factor and no cracks open between them
+    float edgeFactor(vec3 a, vec3 b) {
+        vec3 center = 0.5 * (a + b);
+        float distance = max(length(center - cameraPosition.xyz), 0.001);
+        float pixels = length(a - b) * projectionMatrix[1][1] * 0.5 * viewportHeight / distance;
+        return clamp(pixels / pixelsPerEdge, 1.0, 64.0);
+    }
+
+    void main(){
+        evaluationPosition[gl_InvocationID] = controlPosition[gl_InvocationID];
+        evaluationUV[gl_InvocationID] = controlUV[gl_InvocationID];
+
+        if (gl_InvocationID == 0) {
+            // outer levels run along u = 0, v = 0, u = 1 and v = 1 of the quad domain
+            gl_TessLevelOuter[0] = edgeFactor(controlPosition[0], controlPosition[3]);
+            gl_TessLevelOuter[1] = edgeFactor(controlPosition[0], controlPosition[1]);
+            gl_TessLevelOuter[2] = edgeFactor(controlPosition[1], controlPosition[2]);
+            gl_TessLevelOuter[3] = edgeFactor(controlPosition[3], controlPosition[2]);
+            gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+            gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+        }
+    }
@@ -0,0 +1,31 @@
+#version 400 core
+
+    layout(quads, fractional_even_spacing, ccw) in;
+
+    layout(std140) uniform Camera { // filled once per frame, see cameraBuffer.h
+        mat4 viewMatrix;
+        mat4 projectionMatrix;
+        mat4 viewProjection;
+        vec4 cameraPosition;
+    };
+    uniform sampler2D heightSampler;
+    uniform float mapSize;
+
+    in vec3 evaluationPosition[];
+    in vec2 evaluationUV[];
+    out vec2 vertexUV;
+
+    void main(){
+        vec2 domain = gl_TessCoord.xy;
+        vec3 position = mix(mix(evaluationPosition[0], evaluationPosition[1], domain.x),
+                            mix(evaluationPosition[3], evaluationPosition[2], domain.x), domain.y);
+        vertexUV = mix(mix(evaluationUV[0], evaluationUV[1], domain.x),
+                       mix(evaluationUV[3], evaluationUV[2], domain.x), domain.y);
+
+        // back from world space to height map texels, undoing createTexturedTerrainVAO's placement
+        float offset = mapSize / 2.0;
+        vec2 mapPos = vec2(position.x + offset, -position.z + offset);
+        position.y = textureLod(heightSampler, (mapPos + 0.5) / mapSize, 0.0).r;
+
+        gl_Position = viewProjection * vec4(position, 1.0);
+    }
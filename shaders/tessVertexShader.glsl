@@ -0,0 +1,12 @@
+#version 400 core
+
+    layout(location = 0) in vec3 aPos;      // patch corner in world space
+    layout(location = 1) in vec2 aTexCoord;
+
+    out vec3 controlPosition;
+    out vec2 controlUV;
+
+    void main(){
+        controlPosition = aPos;
+        controlUV = aTexCoord;
+    }
@@ -0,0 +1,171 @@
+#pragma once
+
+// minimal 4-wide float vector used by the culling code
+// SSE on x86, NEON on Apple Silicon / ARM, plain floats everywhere else
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+struct f32x4 {
+#if defined(SIMD_SSE)
+    __m128 v;
+#elif defined(SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+};
+
+inline f32x4 splat4(float a) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_set1_ps(a);
+#elif defined(SIMD_NEON)
+    r.v = vdupq_n_f32(a);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a;
+#endif
+    return r;
+}
+
+// p must point to 4 floats, no alignment requirement
+inline f32x4 load4(const float* p) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_loadu_ps(p);
+#elif defined(SIMD_NEON)
+    r.v = vld1q_f32(p);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = p[i];
+#endif
+    return r;
+}
+
+inline void store4(float* p, f32x4 a) {
+#if defined(SIMD_SSE)
+    _mm_storeu_ps(p, a.v);
+#elif defined(SIMD_NEON)
+    vst1q_f32(p, a.v);
+#else
+    for (int i = 0; i < 4; ++i) p[i] = a.v[i];
+#endif
+}
+
+inline f32x4 operator+(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_add_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vaddq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] + b.v[i];
+#endif
+    return r;
+}
+
+inline f32x4 operator-(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_sub_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vsubq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] - b.v[i];
+#endif
+    return r;
+}
+
+inline f32x4 operator*(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_mul_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vmulq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] * b.v[i];
+#endif
+    return r;
+}
+
+inline f32x4 min4(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_min_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vminq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+inline f32x4 max4(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_max_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vmaxq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+inline f32x4 abs4(f32x4 a) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);
+#elif defined(SIMD_NEON)
+    r.v = vabsq_f32(a.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < 0.0f ? -a.v[i] : a.v[i];
+#endif
+    return r;
+}
+
+// bit i is set when lane i of a is less than lane i of b
+inline int lessMask4(f32x4 a, f32x4 b) {
+#if defined(SIMD_SSE)
+    return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v));
+#elif defined(SIMD_NEON)
+    uint32x4_t lt = vcltq_f32(a.v, b.v);
+    return (vgetq_lane_u32(lt, 0) & 1) | (vgetq_lane_u32(lt, 1) & 2) |
+           (vgetq_lane_u32(lt, 2) & 4) | (vgetq_lane_u32(lt, 3) & 8);
+#else
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) if (a.v[i] < b.v[i]) mask |= 1 << i;
+    return mask;
+#endif
+}
+
+// all bits set in lane i when lane i of a is less than lane i of b, only meant to be
+// passed on to select4
+inline f32x4 less4(f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_cmplt_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    r.v = vreinterpretq_f32_u32(vcltq_f32(a.v, b.v));
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? 1.0f : 0.0f;
+#endif
+    return r;
+}
+
+// lane i of a where mask is set, of b elsewhere
+inline f32x4 select4(f32x4 mask, f32x4 a, f32x4 b) {
+    f32x4 r;
+#if defined(SIMD_SSE)
+    r.v = _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+#elif defined(SIMD_NEON)
+    r.v = vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v);
+#else
+    for (int i = 0; i < 4; ++i) r.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
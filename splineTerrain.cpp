@@ -0,0 +1,47 @@
+#include "splineTerrain.h"
+#include "glState.h"
+#include "heightTexture.h"
+#include "renderStats.h"
+#include "terrain.h"
+#include <iostream>
+
+SplineTerrain createSplineTerrain(const ShaderProgram& shader, int resolution) {
+    SplineTerrain terrain;
+    terrain.shaderProgram = shader.program;
+    terrain.resolution = resolution;
+    terrain.controlTexture = createControlTexture();
+
+    // rows of 2 * resolution strip vertices plus two that repeat the row's last vertex and
+    // the next row's first. the row length is even, so every row starts with the same winding
+    int rowLength = 2 * resolution + 2;
+    terrain.vertexCount = (resolution - 1) * rowLength - 2;
+    glGenVertexArrays(1, &terrain.vao);
+
+    useProgram(shader.program);
+    setUniform(findUniform<int>(shader, "textureSampler"), 0);
+    setUniform(findUniform<int>(shader, "controlSampler"), 1);
+    setUniform(findUniform<int>(shader, "controlSize"), controlSize);
+    setUniform(findUniform<float>(shader, "mapSize"), (float)fineSize);
+    setUniform(findUniform<int>(shader, "resolution"), resolution);
+
+    std::cout << "spline: " << resolution << "x" << resolution << " grid from "
+              << controlSize * controlSize * sizeof(float) << " bytes of control points and no vertex or index data, "
+              << "the baked height texture is " << fineSize * fineSize * sizeof(float) << " bytes" << std::endl;
+
+    return terrain;
+}
+
+void drawSplineTerrain(SplineTerrain& terrain, GLuint texture) {
+    useProgram(terrain.shaderProgram); // camera matrices come from the shared Camera block
+
+    activeTexture(1);
+    bindTexture(GL_TEXTURE_2D, terrain.controlTexture);
+    activeTexture(0);
+    bindTexture(GL_TEXTURE_2D, texture);
+
+    bindVertexArray(terrain.vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, terrain.vertexCount);
+
+    renderStats.drawCalls++;
+    renderStats.trianglesDrawn += 2LL * (terrain.resolution - 1) * (terrain.resolution - 1);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <GL/glew.h>
+#include "shaderProgram.h"
+#include "terrain.h"
+
+// the whole map as one flat grid whose heights the vertex shader evaluates from the
+// controlPoints texture with the same Catmull-Rom spline as generateHeightMap. the grid
+// itself comes from gl_VertexID with no vertex or index buffer, so the control texture
+// is all the memory the mode needs and the grid resolution is free to pick
+const int splineDefaultResolution = 2 * fineSize; // vertices per side
+
+struct SplineTerrain {
+    GLuint shaderProgram;
+    GLuint vao;        // empty, core profile draws need one bound
+    int vertexCount;   // one triangle strip, rows joined by degenerate triangles
+    int resolution;
+    GLuint controlTexture;
+};
+
+SplineTerrain createSplineTerrain(const ShaderProgram& shader, int resolution = splineDefaultResolution);
+void drawSplineTerrain(SplineTerrain& terrain, GLuint texture);
@@ -0,0 +1,130 @@
+#include "streamBuffer.h"
+#include "glState.h"
+#include "renderStats.h"
+#include <chrono>
+#include <iostream>
+
+StreamBuffer createStreamBuffer(GLenum target, GLsizeiptr segmentSize) {
+    StreamBuffer stream;
+    stream.target = target;
+    stream.segmentSize = segmentSize;
+    stream.segment = 0;
+    stream.used = 0;
+    stream.mapped = nullptr;
+    for (int s = 0; s < streamBufferSegments; ++s) {
+        stream.fences[s] = 0;
+    }
+
+    GLsizeiptr size = segmentSize * streamBufferSegments;
+    glGenBuffers(1, &stream.buffer);
+    bindBuffer(target, stream.buffer);
+
+    stream.persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (stream.persistent) {
+        // coherent, so writes become visible to the GPU without flushing
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, size, nullptr, flags);
+        stream.mapped = static_cast<char*>(glMapBufferRange(target, 0, size, flags));
+        if (!stream.mapped) {
+            std::cerr << "Error::Failed to map stream buffer persistently, falling back to orphaning\n";
+            bindBuffer(target, 0); // GL unbinds deleted names, keep the state cache in step
+            glDeleteBuffers(1, &stream.buffer);
+            glGenBuffers(1, &stream.buffer);
+            bindBuffer(target, stream.buffer);
+            stream.persistent = false;
+        }
+    }
+    if (!stream.persistent) {
+        glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+    }
+
+    bindBuffer(target, 0);
+    return stream;
+}
+
+void destroyStreamBuffer(StreamBuffer& stream) {
+    for (int s = 0; s < streamBufferSegments; ++s) {
+        if (stream.fences[s]) {
+            glDeleteSync(stream.fences[s]);
+            stream.fences[s] = 0;
+        }
+    }
+    if (stream.persistent) {
+        bindBuffer(stream.target, stream.buffer);
+        glUnmapBuffer(stream.target);
+    }
+    bindBuffer(stream.target, 0);
+    glDeleteBuffers(1, &stream.buffer);
+    stream.mapped = nullptr;
+}
+
+void beginStreamFrame(StreamBuffer& stream) {
+    stream.used = 0;
+
+    if (!stream.persistent) {
+        // orphan once per trip through the segments, the GPU keeps the old storage
+        // for the frames still in flight and the segments of the new one are untouched
+        if (stream.segment == 0) {
+            bindBuffer(stream.target, stream.buffer);
+            glBufferData(stream.target, stream.segmentSize * streamBufferSegments, nullptr, GL_STREAM_DRAW);
+            bindBuffer(stream.target, 0);
+        }
+        return;
+    }
+
+    GLsync& fence = stream.fences[stream.segment];
+    if (!fence) {
+        return;
+    }
+
+    // normally signalled long ago, only a CPU far ahead of the GPU ends up waiting here
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::high_resolution_clock::now();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+        auto end = std::chrono::high_resolution_clock::now();
+        renderStats.streamWaitMs += std::chrono::duration<float, std::milli>(end - start).count();
+    }
+    if (result == GL_WAIT_FAILED) {
+        std::cerr << "Error::Waiting on stream buffer fence failed\n";
+    }
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+void* mapStreamRange(StreamBuffer& stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset) {
+    // aligned in the whole buffer, segments don't have to be a multiple of alignment
+    GLintptr segmentStart = stream.segmentSize * stream.segment;
+    GLsizeiptr start = (segmentStart + stream.used + alignment - 1) / alignment * alignment - segmentStart;
+    if (start + size > stream.segmentSize) {
+        std::cerr << "Error::Stream buffer segment of " << stream.segmentSize << " bytes is full\n";
+        return nullptr;
+    }
+
+    offset = segmentStart + start;
+    stream.used = start + size;
+    renderStats.bytesStreamed += size;
+
+    if (stream.persistent) {
+        return stream.mapped + offset;
+    }
+
+    // this range hasn't been written since the last orphan, nothing to synchronize with
+    return glMapBufferRange(stream.target, offset, size,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void unmapStreamRange(StreamBuffer& stream) {
+    if (!stream.persistent && glUnmapBuffer(stream.target) == GL_FALSE) {
+        std::cerr << "Error::Stream buffer was lost while mapped\n";
+    }
+}
+
+void endStreamFrame(StreamBuffer& stream) {
+    if (stream.persistent) {
+        stream.fences[stream.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    stream.segment = (stream.segment + 1) % streamBufferSegments;
+}
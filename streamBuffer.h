@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// a buffer for data rewritten every frame, split into streamBufferSegments parts that
+// are used round robin. with GL 4.4 buffer storage the whole buffer stays mapped and a
+// fence per segment tells when the GPU is done reading it, without buffer storage the
+// buffer is orphaned each time it wraps so the driver hands out fresh memory instead
+const int streamBufferSegments = 3; // frames the CPU may run ahead of the GPU
+
+struct StreamBuffer {
+    GLuint buffer;
+    GLenum target;
+    GLsizeiptr segmentSize;
+    int segment;     // segment written this frame
+    GLsizeiptr used; // bytes already handed out from it
+    bool persistent;
+    char* mapped;    // start of the buffer, persistent path only
+    GLsync fences[streamBufferSegments];
+};
+
+StreamBuffer createStreamBuffer(GLenum target, GLsizeiptr segmentSize);
+void destroyStreamBuffer(StreamBuffer& stream);
+
+// waits until the GPU is done with this frame's segment, call before the first write
+void beginStreamFrame(StreamBuffer& stream);
+// size bytes to write, aligned to alignment inside the buffer so that offset / stride can
+// be used as the first vertex of a draw. returns nullptr when the segment is full.
+// the buffer must be bound to its target and unmapStreamRange called before drawing
+void* mapStreamRange(StreamBuffer& stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+void unmapStreamRange(StreamBuffer& stream);
+// fences the segment after the frame's draws were issued and moves on to the next one
+void endStreamFrame(StreamBuffer& stream);
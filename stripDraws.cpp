@@ -0,0 +1,95 @@
+#include "stripDraws.h"
+#include "glState.h"
+#include "renderStats.h"
+#include <iostream>
+
+const char* stripSubmissionNames[StripSubmissionCount] = { "draw loop", "multi draw", "primitive restart", "multi draw indirect" };
+
+// layout fixed by GL for glMultiDrawArraysIndirect
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance; // must be 0 before GL 4.2
+};
+
+StripDraws createStripDraws(GLuint terrainVAO, int stripCount, int verticesPerStrip) {
+    StripDraws draws;
+    draws.stripCount = stripCount;
+    draws.verticesPerStrip = verticesPerStrip;
+
+    std::vector<GLuint> indices;
+    std::vector<DrawArraysIndirectCommand> commands;
+    indices.reserve(stripCount * (verticesPerStrip + 1));
+    for (int strip = 0; strip < stripCount; ++strip) {
+        GLint first = strip * verticesPerStrip;
+        draws.firsts.push_back(first);
+        draws.counts.push_back(verticesPerStrip);
+        commands.push_back({ (GLuint)verticesPerStrip, 1, (GLuint)first, 0 });
+
+        if (strip > 0) {
+            indices.push_back(stripRestartIndex);
+        }
+        for (int v = 0; v < verticesPerStrip; ++v) {
+            indices.push_back(first + v);
+        }
+    }
+    draws.restartIndexCount = static_cast<int>(indices.size());
+
+    bindVertexArray(terrainVAO);
+    glGenBuffers(1, &draws.restartIBO);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, draws.restartIBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    bindVertexArray(0);
+
+    draws.indirectSupported = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+    draws.indirectBuffer = 0;
+    if (draws.indirectSupported) {
+        glGenBuffers(1, &draws.indirectBuffer);
+        bindBuffer(GL_DRAW_INDIRECT_BUFFER, draws.indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawArraysIndirectCommand), commands.data(), GL_STATIC_DRAW);
+        bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    return draws;
+}
+
+void drawStrips(const StripDraws& draws, StripSubmission submission) {
+    if (submission == StripIndirect && !draws.indirectSupported) {
+        static bool warned = false;
+        if (!warned) {
+            std::cerr << "Error::glMultiDrawArraysIndirect needs GL 4.3, using glMultiDrawArrays\n";
+            warned = true;
+        }
+        submission = StripMultiDraw;
+    }
+
+    switch (submission) {
+        case StripDrawLoop:
+            for (int strip = 0; strip < draws.stripCount; ++strip) {
+                glDrawArrays(GL_TRIANGLE_STRIP, draws.firsts[strip], draws.counts[strip]);
+                renderStats.drawCalls++;
+            }
+            break;
+        case StripMultiDraw:
+            glMultiDrawArrays(GL_TRIANGLE_STRIP, draws.firsts.data(), draws.counts.data(), draws.stripCount);
+            renderStats.drawCalls++;
+            break;
+        case StripRestart:
+            setCapability(GL_PRIMITIVE_RESTART, true);
+            glPrimitiveRestartIndex(stripRestartIndex);
+            glDrawElements(GL_TRIANGLE_STRIP, draws.restartIndexCount, GL_UNSIGNED_INT, (void*)0);
+            setCapability(GL_PRIMITIVE_RESTART, false);
+            renderStats.drawCalls++;
+            break;
+        case StripIndirect:
+            bindBuffer(GL_DRAW_INDIRECT_BUFFER, draws.indirectBuffer);
+            glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, (void*)0, draws.stripCount, 0);
+            bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            renderStats.drawCalls++;
+            break;
+        default:
+            break;
+    }
+    renderStats.trianglesDrawn += (long long)draws.stripCount * (draws.verticesPerStrip - 2);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+// ways of submitting the row strips of the full resolution terrain, from one draw
+// call per strip down to a single call
+enum StripSubmission {
+    StripDrawLoop,  // glDrawArrays per strip
+    StripMultiDraw, // glMultiDrawArrays over precomputed first/count arrays
+    StripRestart,   // one glDrawElements, strips separated by the primitive restart index
+    StripIndirect,  // glMultiDrawArraysIndirect from a command buffer built on the CPU
+    StripSubmissionCount
+};
+
+extern const char* stripSubmissionNames[StripSubmissionCount];
+
+const GLuint stripRestartIndex = 0xFFFFFFFF;
+
+struct StripDraws {
+    int stripCount;
+    int verticesPerStrip;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    GLuint restartIBO; // element buffer of the strip VAO, glDrawArrays ignores it
+    int restartIndexCount;
+    GLuint indirectBuffer;
+    bool indirectSupported; // GL 4.3 or ARB_multi_draw_indirect
+};
+
+// stripCount strips of verticesPerStrip vertices each, stored one after the other in terrainVAO
+StripDraws createStripDraws(GLuint terrainVAO, int stripCount, int verticesPerStrip);
+// the strip VAO must be bound
+void drawStrips(const StripDraws& draws, StripSubmission submission);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Constants for control point and terrain resolution
+const int controlSize = 20;
+const int fineSize = 200;
+
+// 2D arrays for control points and resulting height map
+extern float controlPoints[controlSize][controlSize];
+extern float heightMap[fineSize][fineSize];
+
+// creating VAO for terrain
+struct Vertex {
+    glm::vec3 position;
+    glm::vec2 texCoord;
+};
+
+float catmullRom(float p0, float p1, float p2, float p3, float t);
+void generateControlPoints();
+void generateHeightMap();
+float getHeightAt(float worldX, float worldZ);
@@ -0,0 +1,116 @@
+#include "terrainChunks.h"
+#include "jobSystem.h"
+#include "renderStats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+// computes chunk extents and their bounding boxes in world space
+TerrainChunkGrid createTerrainChunks() {
+    TerrainChunkGrid grid;
+    float offset = fineSize / 2.0f;
+
+    for (int cz = 0; cz < chunksPerSide; ++cz) {
+        for (int cx = 0; cx < chunksPerSide; ++cx) {
+            TerrainChunk chunk;
+            chunk.x0 = cx * chunkQuads;
+            chunk.z0 = cz * chunkQuads;
+            chunk.x1 = std::min(chunk.x0 + chunkQuads, fineSize - 1);
+            chunk.z1 = std::min(chunk.z0 + chunkQuads, fineSize - 1);
+
+            float minHeight = heightMap[chunk.z0][chunk.x0];
+            float maxHeight = minHeight;
+            for (int z = chunk.z0; z <= chunk.z1; ++z) {
+                for (int x = chunk.x0; x <= chunk.x1; ++x) {
+                    minHeight = std::min(minHeight, heightMap[z][x]);
+                    maxHeight = std::max(maxHeight, heightMap[z][x]);
+                }
+            }
+
+            // same mapping as createTexturedTerrainVAO: x offset, z flipped and offset
+            chunk.boundsMin = glm::vec3(chunk.x0 - offset, minHeight, -(chunk.z1 - offset));
+            chunk.boundsMax = glm::vec3(chunk.x1 - offset, maxHeight, -(chunk.z0 - offset));
+
+            grid.chunks.push_back(chunk);
+            addBox(grid.bounds, chunk.boundsMin, chunk.boundsMax);
+        }
+    }
+
+    grid.visible.resize(grid.chunks.size(), 1);
+    return grid;
+}
+
+// the frustum and depth buffer tests are per chunk and run on the workers. the horizon
+// sweeps every chunk front to back through one shared horizon, so it stays on this thread
+int testTerrainChunks(TerrainChunkGrid& grid, const FrameCamera& camera) {
+    Frustum frustum = extractFrustumPlanes(camera.viewProjection);
+
+    if (grid.depthOcclusion) {
+        prepareOcclusionTests(*grid.depthOcclusion, camera.viewProjection);
+    }
+
+    // ranges start at multiples of 8, which keeps the simd frustum test on whole lanes
+    std::atomic<int> occluded(0);
+    parallelFor(grid.bounds.count, 8, [&](int begin, int end) {
+        cullBoxes(frustum, grid.bounds, grid.visible.data(), begin, end);
+        if (grid.depthOcclusion) {
+            occluded += cullOccludedRange(*grid.depthOcclusion, grid.bounds, grid.visible.data(), begin, end);
+        }
+    });
+    if (grid.horizon) {
+        occluded += cullBelowHorizon(*grid.horizon, grid.bounds, grid.visible.data(), camera.position);
+    }
+    grid.culled = true;
+    return occluded;
+}
+
+void cullTerrainChunks(TerrainChunkGrid& grid, const FrameCamera& camera) {
+    auto start = std::chrono::high_resolution_clock::now();
+    renderStats.chunksOccluded += testTerrainChunks(grid, camera);
+    auto end = std::chrono::high_resolution_clock::now();
+    renderStats.occlusionMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// queues the visible chunks out of the strip VAO built by createTexturedTerrainVAO,
+// every height map row is one strip so a chunk is a sub-range of each of its rows.
+// neighbouring visible chunks in the same row of chunks are merged into one range.
+// every row of chunks is recorded on a worker thread into a command list of its own
+void submitTerrainChunks(RenderQueue& queue, GLuint shaderProgram, int terrainVAO, GLuint texture, TerrainChunkGrid& grid, const FrameCamera& camera) {
+    cullTerrainChunks(grid, camera);
+
+    const int verticesPerStrip = fineSize * 2;
+
+    recordParallel(queue, chunksPerSide, 1, [&](CommandList& list, int begin, int end) {
+        for (int cz = begin; cz < end; ++cz) {
+            int cx = 0;
+            while (cx < chunksPerSide) {
+                const TerrainChunk& first = grid.chunks[cz * chunksPerSide + cx];
+                if (!grid.visible[cz * chunksPerSide + cx]) {
+                    list.stats.chunksCulled++;
+                    ++cx;
+                    continue;
+                }
+
+                // extend the run over every visible neighbour to the right
+                int last = cx;
+                while (last + 1 < chunksPerSide && grid.visible[cz * chunksPerSide + last + 1]) {
+                    ++last;
+                }
+                list.stats.chunksSubmitted += last - cx + 1;
+
+                int x0 = first.x0;
+                int x1 = grid.chunks[cz * chunksPerSide + last].x1;
+                glm::vec3 center = 0.5f * (first.boundsMin + grid.chunks[cz * chunksPerSide + last].boundsMax);
+                uint64_t key = makeSortKey(RenderPassOpaque, shaderProgram, texture, terrainVAO,
+                                           glm::distance(center, camera.position));
+                for (int z = first.z0; z < first.z1; ++z) {
+                    DrawPacket packet = { shaderProgram, texture, (GLuint)terrainVAO, GL_TRIANGLE_STRIP, 0,
+                                          (x1 - x0 + 1) * 2, z * verticesPerStrip + x0 * 2, 0 };
+                    recordDraw(list, key, packet);
+                }
+
+                cx = last + 1;
+            }
+        }
+    });
+}
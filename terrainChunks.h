@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "depthOcclusion.h"
+#include "frustum.h"
+#include "horizonCulling.h"
+#include "renderQueue.h"
+#include "terrain.h"
+
+// terrain is split into square chunks of chunkQuads x chunkQuads quads,
+// the last row/column of chunks is smaller because fineSize - 1 is not a multiple
+const int chunkQuads = 32;
+const int chunksPerSide = (fineSize - 1 + chunkQuads - 1) / chunkQuads;
+
+// one chunk of the height map, [x0, x1] and [z0, z1] are inclusive vertex ranges
+struct TerrainChunk {
+    int x0, z0;
+    int x1, z1;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+struct TerrainChunkGrid {
+    std::vector<TerrainChunk> chunks; // chunksPerSide * chunksPerSide, row major in z
+    BoxList bounds;                   // same order as chunks
+    std::vector<unsigned char> visible;
+    HorizonCuller* horizon = nullptr;  // hides chunks behind nearer dunes when set
+    DepthOcclusion* depthOcclusion = nullptr; // same with the software depth buffer
+    bool culled = false;              // visible is up to date for this frame, cleared by the caller
+};
+
+TerrainChunkGrid createTerrainChunks();
+// fills visible and returns the number of occluded chunks, renderStats is left alone
+int testTerrainChunks(TerrainChunkGrid& grid, const FrameCamera& camera);
+// testTerrainChunks counted in renderStats, for the modes that draw the chunks
+void cullTerrainChunks(TerrainChunkGrid& grid, const FrameCamera& camera);
+void submitTerrainChunks(RenderQueue& queue, GLuint shaderProgram, int terrainVAO, GLuint texture, TerrainChunkGrid& grid, const FrameCamera& camera);
@@ -0,0 +1,64 @@
+#include "terrainGrid.h"
+#include "glState.h"
+#include "jobSystem.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+// written by the worker threads straight into the mapped buffer, no staging copy
+GLuint createTerrainGridVBO() {
+    const GLsizeiptr bufferSize = (GLsizeiptr)gridSize * gridSize * sizeof(Vertex);
+
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+    Vertex* vertices = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize,
+                                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!vertices) {
+        std::cerr << "Error::Failed to map terrain grid buffer\n";
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+        return vbo;
+    }
+
+    // same placement and texture coordinates as createTexturedTerrainVAO
+    float offset = fineSize / 2.0f;
+    parallelFor(gridSize, 8, [&](int begin, int end) {
+        for (int z = begin; z < end; ++z) {
+            for (int x = 0; x < gridSize; ++x) {
+                int cx = std::min(x, fineSize - 1);
+                int cz = std::min(z, fineSize - 1);
+                float u = cx / (float)(fineSize - 1) * 10.0f;
+                float v = cz / (float)(fineSize - 1) * 10.0f;
+                vertices[gridIndex(x, z)] = {
+                    glm::vec3(cx - offset, heightMap[cz][cx], -(cz - offset)),
+                    glm::vec2(u, v)
+                };
+            }
+        }
+    });
+
+    if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+        std::cerr << "Error::Terrain grid buffer was lost while mapped\n";
+    }
+    bindBuffer(GL_ARRAY_BUFFER, 0);
+    return vbo;
+}
+
+GLuint createTerrainGridVAO(GLuint vbo, GLuint ibo) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    bindVertexArray(vao);
+
+    bindBuffer(GL_ARRAY_BUFFER, vbo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(1);
+
+    bindVertexArray(0);
+    return vao;
+}
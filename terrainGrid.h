@@ -0,0 +1,22 @@
+#pragma once
+
+#include <GL/glew.h>
+#include "terrainChunks.h"
+
+// indexed version of the terrain, one vertex per height map sample, padded up to
+// a whole number of chunks. padding vertices are clamped onto the last row/column
+// so they only ever produce zero area triangles
+const int gridSize = chunksPerSide * chunkQuads + 1;
+
+inline int gridIndex(int x, int z) {
+    return z * gridSize + x;
+}
+
+// height of a padded grid vertex
+inline float gridHeight(int x, int z) {
+    return heightMap[z < fineSize ? z : fineSize - 1][x < fineSize ? x : fineSize - 1];
+}
+
+GLuint createTerrainGridVBO();
+// creates a VAO with the Vertex layout over vbo, ibo becomes its element buffer
+GLuint createTerrainGridVAO(GLuint vbo, GLuint ibo);
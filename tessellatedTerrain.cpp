@@ -0,0 +1,126 @@
+#include "tessellatedTerrain.h"
+#include "glState.h"
+#include "renderStats.h"
+#include "terrain.h"
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+bool tessellationSupported() {
+    // the stages are #version 400, the extension alone on an older context can't compile them
+    return GLEW_VERSION_4_0;
+}
+
+TessellatedTerrain createTessellatedTerrain(const ShaderProgram* shader, GLuint heightTexture) {
+    TessellatedTerrain terrain = {};
+    terrain.supported = shader != nullptr && tessellationSupported();
+    if (!terrain.supported) {
+        std::cout << "tessellation: needs OpenGL 4.0, the mode draws nothing" << std::endl;
+        return terrain;
+    }
+    int linked;
+    glGetProgramiv(shader->program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        terrain.supported = false;
+        std::cout << "tessellation: program failed to link, the mode draws nothing" << std::endl;
+        return terrain;
+    }
+    terrain.shaderProgram = shader->program;
+    terrain.heightTexture = heightTexture;
+
+    // patch corners every tessPatchQuads texels, the last row and column end on the map edge
+    std::vector<int> corners;
+    for (int x = 0; x < fineSize - 1; x += tessPatchQuads) {
+        corners.push_back(x);
+    }
+    corners.push_back(fineSize - 1);
+    int side = static_cast<int>(corners.size());
+
+    // same placement and texture coordinates as createTexturedTerrainVAO, the corner
+    // heights are only used to size the tessellation factors
+    float offset = fineSize / 2.0f;
+    std::vector<Vertex> vertices;
+    for (int z : corners) {
+        for (int x : corners) {
+            float u = x / (float)(fineSize - 1) * 10.0f;
+            float v = z / (float)(fineSize - 1) * 10.0f;
+            vertices.push_back({ glm::vec3(x - offset, heightMap[z][x], -(z - offset)), glm::vec2(u, v) });
+        }
+    }
+
+    // corners counter-clockwise seen from above, matching the evaluation shader's domain
+    std::vector<unsigned short> indices;
+    for (int j = 0; j + 1 < side; ++j) {
+        for (int i = 0; i + 1 < side; ++i) {
+            unsigned short a = j * side + i;
+            indices.insert(indices.end(), { a, (unsigned short)(a + 1), (unsigned short)(a + side + 1), (unsigned short)(a + side) });
+        }
+    }
+    terrain.indexCount = static_cast<int>(indices.size());
+
+    glGenVertexArrays(1, &terrain.vao);
+    bindVertexArray(terrain.vao);
+
+    glGenBuffers(1, &terrain.vbo);
+    bindBuffer(GL_ARRAY_BUFFER, terrain.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(1);
+
+    glGenBuffers(1, &terrain.ibo);
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    bindVertexArray(0);
+
+    glGenQueries(tessQueryCount, terrain.queries);
+    terrain.queryFrame = 0;
+
+    useProgram(shader->program);
+    setUniform(findUniform<int>(*shader, "textureSampler"), 0);
+    setUniform(findUniform<int>(*shader, "heightSampler"), 1);
+    setUniform(findUniform<float>(*shader, "mapSize"), (float)fineSize);
+    setUniform(findUniform<float>(*shader, "pixelsPerEdge"), tessPixelsPerEdge);
+    terrain.viewportHeight = findUniform<float>(*shader, "viewportHeight");
+
+    std::cout << "tessellation: " << terrain.indexCount / 4 << " patches of " << tessPatchQuads << "x"
+              << tessPatchQuads << " height map quads" << std::endl;
+    return terrain;
+}
+
+void drawTessellatedTerrain(TessellatedTerrain& terrain, GLuint texture, const FrameCamera& camera) {
+    if (!terrain.supported) {
+        return;
+    }
+
+    // the oldest query is reused this frame, collect it first if the GPU is done with it
+    GLuint query = terrain.queries[terrain.queryFrame % tessQueryCount];
+    if (terrain.queryFrame >= tessQueryCount) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 primitives = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &primitives);
+            renderStats.trianglesDrawn += (long long)primitives;
+        }
+    }
+
+    useProgram(terrain.shaderProgram); // camera matrices come from the shared Camera block
+    setUniform(terrain.viewportHeight, (float)camera.viewportHeight);
+
+    activeTexture(1);
+    bindTexture(GL_TEXTURE_2D, terrain.heightTexture);
+    activeTexture(0);
+    bindTexture(GL_TEXTURE_2D, texture);
+
+    bindVertexArray(terrain.vao);
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+    glDrawElements(GL_PATCHES, terrain.indexCount, GL_UNSIGNED_SHORT, (void*)0);
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    terrain.queryFrame++;
+
+    renderStats.drawCalls++;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <GL/glew.h>
+#include "camera.h"
+#include "shaderProgram.h"
+
+// GL 4.0 hardware tessellation: a coarse grid of quad patches laid out like
+// createTexturedTerrainVAO, subdivided on the GPU until every edge covers about
+// tessPixelsPerEdge pixels, with heights read from the height texture
+const int tessPatchQuads = 8;           // height map quads per patch side
+const float tessPixelsPerEdge = 8.0f;   // target screen space length of a tessellated edge
+const int tessQueryCount = 3;           // primitives generated queries in flight
+
+struct TessellatedTerrain {
+    bool supported; // false without GL 4.0 or when the program failed to link, drawing does nothing then
+    GLuint shaderProgram;
+    GLuint vao, vbo, ibo;
+    int indexCount;
+    GLuint heightTexture;
+    // triangle counts come back from the GPU, read a few frames later so nothing stalls
+    GLuint queries[tessQueryCount];
+    int queryFrame;
+
+    Uniform<float> viewportHeight;
+};
+
+bool tessellationSupported();
+// the shader is only compiled when tessellation is supported, pass it in from createTessellationProgram
+TessellatedTerrain createTessellatedTerrain(const ShaderProgram* shader, GLuint heightTexture);
+void drawTessellatedTerrain(TessellatedTerrain& terrain, GLuint texture, const FrameCamera& camera);
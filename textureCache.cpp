@@ -0,0 +1,190 @@
+#include "textureCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TextureCacheStats textureCacheStats;
+
+struct TextureCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;        // repeated here so a renamed or colliding file is caught
+    int32_t channels;
+    int32_t levelCount;
+};
+
+struct TextureCacheLevel {
+    int32_t width, height;
+    uint64_t offset;     // from the start of the file, 16 byte aligned
+    uint64_t size;
+};
+
+const uint32_t textureCacheMagic = 0x31435854; // "TXC1"
+
+bool mapFile(const std::string& path, MappedFile& file) {
+#ifndef _WIN32
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        close(descriptor);
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // the mapping keeps the file alive on its own
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    file.data = static_cast<const unsigned char*>(data);
+    file.size = (size_t)info.st_size;
+    return true;
+#else
+    if (!readSourceFile(path, file.buffer) || file.buffer.empty()) {
+        return false;
+    }
+    file.data = file.buffer.data();
+    file.size = file.buffer.size();
+    return true;
+#endif
+}
+
+void unmapFile(MappedFile& file) {
+#ifndef _WIN32
+    if (file.data) {
+        munmap(const_cast<unsigned char*>(file.data), file.size);
+    }
+#endif
+    file.buffer.clear();
+    file.data = nullptr;
+    file.size = 0;
+}
+
+bool readSourceFile(const std::string& path, std::vector<unsigned char>& bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// 64 bit FNV-1a
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t textureSourceHash(const std::vector<unsigned char>& source) {
+    return hashBytes(0xcbf29ce484222325ULL, source.data(), source.size());
+}
+
+uint64_t textureCacheKey(uint64_t sourceHash, const MipSettings& settings) {
+    uint32_t options[4] = { textureCacheVersion, (uint32_t)settings.filter, settings.srgb, settings.wrap };
+    return hashBytes(sourceHash, options, sizeof(options));
+}
+
+std::string textureCachePath(uint64_t key) {
+    std::ostringstream path;
+    path << textureCacheDirectory << "/" << std::hex;
+    path.width(16);
+    path.fill('0');
+    path << key << ".texcache";
+    return path.str();
+}
+
+bool readTextureCache(uint64_t key, MappedFile& file, int& channels, std::vector<CachedLevel>& levels) {
+    if (!mapFile(textureCachePath(key), file)) {
+        return false;
+    }
+
+    // anything that doesn't add up is treated as a miss and overwritten by the next decode
+    TextureCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, file.data, sizeof(header));
+        valid = header.magic == textureCacheMagic && header.version == textureCacheVersion && header.key == key &&
+                header.channels >= 1 && header.channels <= 4 && header.levelCount >= 1 && header.levelCount <= 16 &&
+                file.size >= sizeof(header) + header.levelCount * sizeof(TextureCacheLevel);
+    }
+
+    levels.clear();
+    for (int i = 0; valid && i < header.levelCount; ++i) {
+        TextureCacheLevel level;
+        std::memcpy(&level, file.data + sizeof(header) + i * sizeof(level), sizeof(level));
+        valid = level.width >= 1 && level.height >= 1 &&
+                level.size == (uint64_t)level.width * level.height * header.channels &&
+                level.offset <= file.size && level.size <= file.size - level.offset;
+        levels.push_back({ level.width, level.height, file.data + level.offset, (size_t)level.size });
+    }
+
+    if (!valid) {
+        std::cerr << "Error::" << textureCachePath(key) << " is not a valid texture cache entry\n";
+        levels.clear();
+        unmapFile(file);
+        return false;
+    }
+    channels = header.channels;
+    return true;
+}
+
+bool writeTextureCache(uint64_t key, int channels, const std::vector<MipLevel>& levels) {
+    std::string path = textureCachePath(key);
+    // unique per key, two loads of the same file race to the same content anyway
+    std::string temporary = path + ".tmp";
+
+    std::error_code error;
+    std::filesystem::create_directories(textureCacheDirectory, error);
+
+    std::ofstream file(temporary, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error::Could not write " << temporary << std::endl;
+        return false;
+    }
+
+    TextureCacheHeader header = { textureCacheMagic, textureCacheVersion, key, channels, (int32_t)levels.size() };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset = sizeof(header) + levels.size() * sizeof(TextureCacheLevel);
+    for (const MipLevel& level : levels) {
+        offset = (offset + 15) & ~15ULL;
+        TextureCacheLevel entry = { level.width, level.height, offset, level.pixels.size() };
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += level.pixels.size();
+    }
+
+    const char padding[16] = {};
+    for (const MipLevel& level : levels) {
+        file.write(padding, (16 - file.tellp() % 16) % 16);
+        file.write(reinterpret_cast<const char*>(level.pixels.data()), level.pixels.size());
+    }
+    file.close();
+
+    if (!file) {
+        std::cerr << "Error::Could not write " << temporary << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cerr << "Error::Could not write " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
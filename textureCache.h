@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mipChain.h"
+
+// disk cache of decoded mip chains. an entry is named after the hash of the source file's
+// bytes and of the options that shape the pixels, and holds a small header followed by the
+// raw levels, so a warm start maps the file and hands the levels to GL without decoding
+const char* const textureCacheDirectory = "textureCache";
+const uint32_t textureCacheVersion = 1; // bump when the mip builder or the file layout changes
+
+struct TextureCacheStats {
+    std::atomic<int> hits{0};
+    std::atomic<int> misses{0};
+};
+
+extern TextureCacheStats textureCacheStats;
+
+// a read only view of a whole file, memory mapped where the platform allows it
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    std::vector<unsigned char> buffer; // read into memory where there is no mmap
+};
+
+bool mapFile(const std::string& path, MappedFile& file);
+void unmapFile(MappedFile& file);
+
+struct CachedLevel {
+    int width, height;
+    const unsigned char* pixels; // inside the mapped file
+    size_t size;
+};
+
+bool readSourceFile(const std::string& path, std::vector<unsigned char>& bytes);
+// hash of the source file's bytes, also stamped into baked .dds files to spot stale bakes
+uint64_t textureSourceHash(const std::vector<unsigned char>& source);
+uint64_t textureCacheKey(uint64_t sourceHash, const MipSettings& settings);
+std::string textureCachePath(uint64_t key);
+
+// maps the entry for key, levels stay valid until file is unmapped. false on a miss or a bad entry
+bool readTextureCache(uint64_t key, MappedFile& file, int& channels, std::vector<CachedLevel>& levels);
+// writes to a temporary name and renames it, a reader never sees half an entry
+bool writeTextureCache(uint64_t key, int channels, const std::vector<MipLevel>& levels);
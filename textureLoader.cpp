@@ -0,0 +1,289 @@
+#include "textureLoader.h"
+#include "compressedTexture.h"
+#include "ddsFile.h"
+#include "glState.h"
+#include "mipChain.h"
+#include "renderStats.h"
+#include "stb_image.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// runs on a worker: reads the baked .dds when the context can sample it and it was baked
+// from the PNG as it is now, then tries the texture cache, and only decodes the PNG and
+// builds its mip chain when both miss
+static void decodeTexture(void* context, int, int) {
+    PendingTexture& texture = *static_cast<PendingTexture*>(context);
+
+    // a bake still counts without its PNG, there is nothing it could be stale against
+    std::vector<unsigned char> source;
+    bool haveSource = readSourceFile(texture.path, source) && !source.empty();
+    uint64_t sourceHash = haveSource ? textureSourceHash(source) : 0;
+
+    DdsImage image;
+    std::string bakedPath = bakedTexturePath(texture.path.c_str());
+    if (readDdsFile(bakedPath, image) && blockFormatSupported(image.format)) {
+        if (!haveSource || image.sourceHash == sourceHash) {
+            texture.compressed = true;
+            texture.format = blockInternalFormat(image.format);
+            texture.blockBytes = blockBytes(image.format);
+            texture.storage = std::move(image.levels);
+            int width = image.width, height = image.height;
+            for (const std::vector<unsigned char>& level : texture.storage) {
+                texture.levels.push_back({ width, height, level.data(), level.size() });
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+            return;
+        }
+        std::cerr << "Error::" << bakedPath << " was baked from an older " << texture.path
+                  << ", using the PNG until --bake-textures runs again\n";
+    }
+
+    if (!haveSource) {
+        texture.failed = true;
+        return;
+    }
+    texture.compressed = false;
+
+    MipSettings settings;
+    uint64_t key = textureCacheKey(sourceHash, settings);
+    std::vector<CachedLevel> cached;
+    int channels;
+    if (readTextureCache(key, texture.cacheFile, channels, cached)) {
+        textureCacheStats.hits++;
+        texture.cacheHit = true;
+        texture.channels = channels;
+        texture.format = channels == 1 ? GL_RED : channels == 4 ? GL_RGBA : GL_RGB;
+        for (const CachedLevel& level : cached) {
+            texture.levels.push_back({ level.width, level.height, level.pixels, level.size });
+        }
+        return;
+    }
+    textureCacheStats.misses++;
+
+    int width, height;
+    unsigned char* data = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 0);
+    if (!data) {
+        texture.failed = true;
+        return;
+    }
+    texture.channels = channels;
+    texture.format = channels == 1 ? GL_RED : channels == 4 ? GL_RGBA : GL_RGB;
+    std::vector<MipLevel> chain = buildMipChain(data, width, height, channels, settings);
+    stbi_image_free(data);
+
+    writeTextureCache(key, channels, chain);
+    for (MipLevel& level : chain) {
+        texture.storage.push_back(std::move(level.pixels));
+        const std::vector<unsigned char>& pixels = texture.storage.back();
+        texture.levels.push_back({ level.width, level.height, pixels.data(), pixels.size() });
+    }
+}
+
+TextureLoader createTextureLoader() {
+    TextureLoader loader;
+    loader.pixelStream = createStreamBuffer(GL_PIXEL_UNPACK_BUFFER, textureUploadBudget);
+    return loader;
+}
+
+void destroyTextureLoader(TextureLoader& loader) {
+    for (std::unique_ptr<PendingTexture>& texture : loader.pending) {
+        waitForJob(*texture->decode);
+        unmapFile(texture->cacheFile);
+    }
+    loader.pending.clear();
+    destroyStreamBuffer(loader.pixelStream);
+}
+
+GLuint loadTextureAsync(TextureLoader& loader, const char* path, glm::vec3 placeholder) {
+    std::unique_ptr<PendingTexture> texture = std::make_unique<PendingTexture>();
+    glGenTextures(1, &texture->texture);
+    texture->path = path;
+    texture->failed = false;
+    texture->cacheHit = false;
+    texture->allocated = false;
+    texture->uploadLevel = -1;
+    texture->uploadRow = 0;
+    texture->startTime = glfwGetTime();
+
+    unsigned char texel[3] = {
+        (unsigned char)(placeholder.x * 255.0f + 0.5f),
+        (unsigned char)(placeholder.y * 255.0f + 0.5f),
+        (unsigned char)(placeholder.z * 255.0f + 0.5f),
+    };
+    bindTexture(GL_TEXTURE_2D, texture->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    bindTexture(GL_TEXTURE_2D, 0);
+
+    texture->decode = std::make_unique<Job>();
+    Job& job = *texture->decode;
+    job.run = decodeTexture;
+    job.context = texture.get();
+    job.count = 1;
+    job.grain = 1;
+    texture->queued = submitJob(job);
+
+    GLuint name = texture->texture;
+    loader.pending.push_back(std::move(texture));
+    return name;
+}
+
+// bytes of one upload row: a texel row, or a row of 4x4 blocks
+static GLsizeiptr rowBytes(const PendingTexture& texture, const TextureLevel& level) {
+    if (texture.compressed) {
+        return (GLsizeiptr)((level.width + 3) / 4) * texture.blockBytes;
+    }
+    return (GLsizeiptr)level.width * texture.channels;
+}
+
+static int rowHeight(const PendingTexture& texture) {
+    return texture.compressed ? 4 : 1;
+}
+
+// replaces the placeholder with storage for every level and fills the smallest one directly,
+// it is a few bytes and makes the texture complete before any pixel buffer copy
+static void allocateLevels(PendingTexture& texture) {
+    bindTexture(GL_TEXTURE_2D, texture.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    int last = static_cast<int>(texture.levels.size()) - 1;
+    for (int level = 0; level <= last; ++level) {
+        const TextureLevel& data = texture.levels[level];
+        const void* pixels = level == last ? data.data : nullptr;
+        if (texture.compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.format, data.width, data.height, 0,
+                                   (GLsizei)data.size, pixels);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, level, texture.format, data.width, data.height, 0,
+                         texture.format, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+    texture.allocated = true;
+    texture.uploadLevel = last - 1;
+    texture.uploadRow = 0;
+}
+
+// copies rows of the current level through the stream buffer until the level, the texture
+// or the frame's budget runs out. returns false once the budget is spent
+static bool uploadRows(TextureLoader& loader, PendingTexture& texture) {
+    while (texture.uploadLevel >= 0) {
+        const TextureLevel& level = texture.levels[texture.uploadLevel];
+        GLsizeiptr bytesPerRow = rowBytes(texture, level);
+        int rowCount = (level.height + rowHeight(texture) - 1) / rowHeight(texture);
+        int firstRow = texture.uploadRow / rowHeight(texture);
+
+        GLsizeiptr space = loader.pixelStream.segmentSize - loader.pixelStream.used - 16;
+        int rows = std::min(rowCount - firstRow, (int)(space / bytesPerRow));
+        if (rows <= 0) {
+            return false;
+        }
+
+        GLintptr offset = 0;
+        void* destination = mapStreamRange(loader.pixelStream, rows * bytesPerRow, 16, offset);
+        if (!destination) {
+            return false;
+        }
+        std::memcpy(destination, level.data + firstRow * bytesPerRow, rows * bytesPerRow);
+        unmapStreamRange(loader.pixelStream);
+        renderStats.textureBytesUploaded += rows * bytesPerRow;
+
+        int y = texture.uploadRow;
+        int height = std::min(rows * rowHeight(texture), level.height - y);
+        bindTexture(GL_TEXTURE_2D, texture.texture);
+        if (texture.compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, texture.uploadLevel, 0, y, level.width, height, texture.format,
+                                      (GLsizei)(rows * bytesPerRow), (void*)offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, texture.uploadLevel, 0, y, level.width, height, texture.format,
+                            GL_UNSIGNED_BYTE, (void*)offset);
+        }
+        texture.uploadRow += height;
+
+        // a finished level becomes the new base, sampling never sees a level still being filled
+        if (texture.uploadRow >= level.height) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.uploadLevel);
+            texture.uploadLevel--;
+            texture.uploadRow = 0;
+        }
+    }
+    return true;
+}
+
+void updateTextureLoader(TextureLoader& loader) {
+    if (loader.pending.empty()) {
+        return;
+    }
+
+    // decodes that never reached a worker (no workers, or the queue was full) run here
+    for (std::unique_ptr<PendingTexture>& texture : loader.pending) {
+        if (!texture->queued) {
+            waitForJob(*texture->decode);
+        }
+    }
+
+    // storage has to be specified while no unpack buffer is bound, a null pointer would read from it
+    for (std::unique_ptr<PendingTexture>& texture : loader.pending) {
+        if (!texture->allocated && jobFinished(*texture->decode) && !texture->failed) {
+            allocateLevels(*texture);
+        }
+    }
+
+    beginStreamFrame(loader.pixelStream);
+    bindBuffer(GL_PIXEL_UNPACK_BUFFER, loader.pixelStream.buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (std::unique_ptr<PendingTexture>& texture : loader.pending) {
+        if (texture->uploadLevel >= 0 && !uploadRows(loader, *texture)) {
+            break;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    bindTexture(GL_TEXTURE_2D, 0);
+    endStreamFrame(loader.pixelStream);
+
+    // finished and failed textures leave the list, failed ones keep their placeholder
+    for (size_t i = 0; i < loader.pending.size();) {
+        PendingTexture& texture = *loader.pending[i];
+        // failed and the levels are written by the decode job, only read them once it is done
+        if (!jobFinished(*texture.decode)) {
+            ++i;
+            continue;
+        }
+        bool resident = texture.allocated && texture.uploadLevel < 0;
+        if (!texture.failed && !resident) {
+            ++i;
+            continue;
+        }
+        if (texture.failed) {
+            std::cerr << "Error::Texture could not load texture file: " << texture.path << std::endl;
+        } else {
+            const char* source = texture.compressed ? "baked .dds" : texture.cacheHit ? "texture cache" : "PNG";
+            std::cout << texture.path << ": " << source << ", " << texture.levels.size() << " levels resident after "
+                      << (glfwGetTime() - texture.startTime) * 1000.0 << " ms" << std::endl;
+        }
+        // the decode job has to be out of the job queue before its PendingTexture goes away
+        waitForJob(*texture.decode);
+        unmapFile(texture.cacheFile);
+        loader.pending.erase(loader.pending.begin() + i);
+
+        if (loader.pending.empty()) {
+            std::cout << "texture cache: " << textureCacheStats.hits << " hits, "
+                      << textureCacheStats.misses << " misses" << std::endl;
+        }
+    }
+}
+
+bool textureLoaderIdle(const TextureLoader& loader) {
+    return loader.pending.empty();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "jobSystem.h"
+#include "streamBuffer.h"
+#include "textureCache.h"
+
+// textures decoded on the worker threads and uploaded through a pixel unpack stream buffer,
+// at most textureUploadBudget bytes per frame. the texture name is handed out at once with
+// a one texel placeholder, then the mip levels arrive smallest first and GL_TEXTURE_BASE_LEVEL
+// follows them down, so the texture sharpens over a few frames instead of stalling one
+const GLsizeiptr textureUploadBudget = 2 * 1024 * 1024;
+
+struct TextureLevel {
+    int width, height;
+    const unsigned char* data; // into storage or cacheFile of its PendingTexture
+    size_t size;
+};
+
+struct PendingTexture {
+    GLuint texture;
+    std::string path;
+    std::unique_ptr<Job> decode; // Job can't be moved, this keeps PendingTexture movable
+    bool queued;                 // decode went to the workers, otherwise updateTextureLoader runs it
+
+    // written by the decode job, read once it has finished
+    bool failed;
+    bool compressed;     // levels hold blocks of a baked .dds
+    GLenum format;       // pixel format, or the compressed internal format
+    int blockBytes;      // compressed only
+    int channels;        // uncompressed only
+    bool cacheHit;       // levels were mapped from the texture cache, nothing was decoded
+    std::vector<TextureLevel> levels;
+    std::vector<std::vector<unsigned char>> storage;
+    MappedFile cacheFile;
+
+    bool allocated;      // storage for every level exists, the placeholder is gone
+    int uploadLevel;     // level being copied, counts down to 0 and ends at -1
+    int uploadRow;       // texel rows of uploadLevel already copied
+    double startTime;    // glfw time of the request, for the load time printout
+};
+
+struct TextureLoader {
+    StreamBuffer pixelStream;
+    std::vector<std::unique_ptr<PendingTexture>> pending;
+};
+
+TextureLoader createTextureLoader();
+// waits for outstanding decodes so no job outlives the loader
+void destroyTextureLoader(TextureLoader& loader);
+
+// prefers an up to date .dds baked next to the PNG, then the texture cache, and only decodes
+// on a miss. the texture is usable right away, showing placeholder (0..1 RGB) until its
+// levels are resident. wraps with GL_REPEAT and filters trilinearly
+GLuint loadTextureAsync(TextureLoader& loader, const char* path, glm::vec3 placeholder);
+// once per frame on the GL thread, copies decoded levels until the budget is spent
+void updateTextureLoader(TextureLoader& loader);
+bool textureLoaderIdle(const TextureLoader& loader);
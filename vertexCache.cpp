@@ -0,0 +1,168 @@
+#include "vertexCache.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+// score of a vertex by its LRU position and by how many triangles still use it, from
+// "Linear-Speed Vertex Cache Optimisation": the last triangle's vertices get a fixed
+// score so the next triangle doesn't just reuse one edge, lonely vertices get a boost
+static float vertexScore(int cachePosition, int remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = 0.75f;
+        } else {
+            float scaler = 1.0f / (forsythCacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+        }
+    }
+    return score + 2.0f * std::pow((float)remainingTriangles, -0.5f);
+}
+
+template <class Index>
+void optimizeVertexCache(Index* indices, int indexCount) {
+    int triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // indices are global grid indices, renumber them densely for the per vertex tables
+    std::unordered_map<Index, int> localIndex;
+    std::vector<int> triangleVertices(indexCount);
+    for (int i = 0; i < indexCount; ++i) {
+        auto inserted = localIndex.emplace(indices[i], static_cast<int>(localIndex.size()));
+        triangleVertices[i] = inserted.first->second;
+    }
+    int vertexCount = static_cast<int>(localIndex.size());
+
+    // triangles using each vertex, flattened
+    std::vector<int> remaining(vertexCount, 0);
+    for (int v : triangleVertices) {
+        remaining[v]++;
+    }
+    std::vector<int> adjacencyStart(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; ++v) {
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    }
+    std::vector<int> adjacency(indexCount);
+    std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (int i = 0; i < indexCount; ++i) {
+        adjacency[fill[triangleVertices[i]]++] = i / 3;
+    }
+
+    std::vector<float> score(vertexCount);
+    for (int v = 0; v < vertexCount; ++v) {
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    for (int t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = score[triangleVertices[t * 3]] + score[triangleVertices[t * 3 + 1]] + score[triangleVertices[t * 3 + 2]];
+    }
+
+    std::vector<Index> output;
+    output.reserve(indexCount);
+    std::vector<int> cache;
+    std::vector<int> evicted;
+    cache.reserve(forsythCacheSize + 3);
+
+    int bestTriangle = static_cast<int>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    int scanFrom = 0;
+
+    for (int emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestTriangle < 0) {
+            // nothing left next to the cache, fall back to the first triangle not yet drawn
+            while (emitted[scanFrom]) {
+                ++scanFrom;
+            }
+            bestTriangle = scanFrom;
+        }
+
+        emitted[bestTriangle] = 1;
+        for (int k = 0; k < 3; ++k) {
+            int v = triangleVertices[bestTriangle * 3 + k];
+            output.push_back(indices[bestTriangle * 3 + k]);
+            remaining[v]--;
+
+            // move the vertex to the front of the LRU cache
+            auto found = std::find(cache.begin(), cache.end(), v);
+            if (found != cache.end()) {
+                cache.erase(found);
+            }
+            cache.insert(cache.begin(), v);
+        }
+
+        // vertices pushed out of the cache lose their position score
+        evicted.clear();
+        while ((int)cache.size() > forsythCacheSize) {
+            int v = cache.back();
+            cache.pop_back();
+            score[v] = vertexScore(-1, remaining[v]);
+            evicted.push_back(v);
+        }
+
+        for (int i = 0; i < (int)cache.size(); ++i) {
+            score[cache[i]] = vertexScore(i, remaining[cache[i]]);
+        }
+
+        // rescore triangles around the cache and pick the best of them
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        auto rescore = [&](int v) {
+            for (int a = adjacencyStart[v]; a < adjacencyStart[v + 1]; ++a) {
+                int t = adjacency[a];
+                if (emitted[t]) {
+                    continue;
+                }
+                triangleScore[t] = score[triangleVertices[t * 3]] + score[triangleVertices[t * 3 + 1]] + score[triangleVertices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        };
+        for (int v : cache) {
+            rescore(v);
+        }
+        for (int v : evicted) {
+            rescore(v);
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template <class Index>
+VertexCacheStats simulateVertexCache(const Index* indices, int indexCount) {
+    VertexCacheStats stats;
+    stats.triangles = indexCount / 3;
+
+    Index fifo[simulatedCacheSize];
+    int used = 0;
+    int head = 0;
+    for (int i = 0; i < indexCount; ++i) {
+        bool hit = std::find(fifo, fifo + used, indices[i]) != fifo + used;
+        if (hit) {
+            continue;
+        }
+        stats.vertexShaderInvocations++;
+        if (used < simulatedCacheSize) {
+            fifo[used++] = indices[i];
+        } else {
+            fifo[head] = indices[i];
+            head = (head + 1) % simulatedCacheSize;
+        }
+    }
+    return stats;
+}
+
+template void optimizeVertexCache<unsigned short>(unsigned short*, int);
+template void optimizeVertexCache<unsigned int>(unsigned int*, int);
+template VertexCacheStats simulateVertexCache<unsigned short>(const unsigned short*, int);
+template VertexCacheStats simulateVertexCache<unsigned int>(const unsigned int*, int);
@@ -0,0 +1,29 @@
+#pragma once
+
+// post-transform vertex cache helpers for indexed triangle lists
+const int forsythCacheSize = 32;  // LRU size assumed by the optimizer
+const int simulatedCacheSize = 16; // FIFO size used when measuring
+
+struct VertexCacheStats {
+    long long triangles = 0;
+    long long vertexShaderInvocations = 0; // cache misses
+
+    // average cache miss ratio, vertex shader runs per triangle
+    double acmr() const {
+        return triangles > 0 ? (double)vertexShaderInvocations / triangles : 0.0;
+    }
+    VertexCacheStats& operator+=(const VertexCacheStats& other) {
+        triangles += other.triangles;
+        vertexShaderInvocations += other.vertexShaderInvocations;
+        return *this;
+    }
+};
+
+// reorders the triangles in place with Tom Forsyth's linear-speed algorithm,
+// the index values themselves are left alone
+template <class Index>
+void optimizeVertexCache(Index* indices, int indexCount);
+
+// runs the triangle list through a FIFO cache of simulatedCacheSize entries
+template <class Index>
+VertexCacheStats simulateVertexCache(const Index* indices, int indexCount);